@@ -0,0 +1,247 @@
+#ifndef HEPMC_BARCODE_INDEX_H
+#define HEPMC_BARCODE_INDEX_H
+
+//////////////////////////////////////////////////////////////////////////
+// BarcodeIndex.h
+//
+// Lookup table from barcode to particle or vertex, used by GenEvent
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace HepMC {
+
+  namespace detail {
+
+    //! BarcodeIndex maps positive integer keys onto object pointers
+
+    ///
+    /// \class BarcodeIndex
+    /// Keys are almost always dense (1..N), so they are kept in a vector
+    /// covering a window of consecutive keys, with a std::map for the
+    /// occasional key far outside that window.
+    /// Iteration visits the entries in increasing key order, exactly like
+    /// a std::map<int,T*>, but is a linear scan over contiguous memory.
+    ///
+    /// Erasing an entry does not invalidate iterators to other entries.
+    /// Inserting may invalidate them.
+    ///
+    /// GenEvent uses the barcode as key for particles and minus the
+    /// barcode as key for vertices.
+    ///
+    template <class T>
+    class BarcodeIndex {
+    public:
+      typedef std::map<int,T*>  SparseMap;
+
+      /// Iterates over the entries in increasing key order
+      class const_iterator {
+      public:
+        const_iterator() : m_index(0), m_pos(0), m_sparse() {}
+        /// the object
+        T* operator*() const
+        { return from_dense() ? m_index->m_dense[m_pos] : m_sparse->second; }
+        /// the key
+        int key() const
+        { return from_dense() ? m_index->m_offset + (int)m_pos : m_sparse->first; }
+        /// Pre-fix increment
+        const_iterator& operator++() {
+          if ( from_dense() ) {
+            m_pos = m_index->next_used( m_pos + 1 );
+          } else {
+            ++m_sparse;
+          }
+          return *this;
+        }
+        /// Post-fix increment
+        const_iterator operator++(int) { const_iterator out(*this); ++(*this); return out; }
+        /// equality
+        bool operator==( const const_iterator& a ) const {
+          return m_sparse == a.m_sparse && dense_pos() == a.dense_pos();
+        }
+        /// inequality
+        bool operator!=( const const_iterator& a ) const { return !( *this == a ); }
+
+      private:
+        friend class BarcodeIndex;
+        const_iterator( const BarcodeIndex* index, std::size_t pos,
+                        typename SparseMap::const_iterator sparse )
+          : m_index(index), m_pos(pos), m_sparse(sparse) {}
+        /// position in the dense window, or its end if the window is exhausted
+        std::size_t dense_pos() const {
+          if ( !m_index ) return 0;
+          return m_pos < m_index->m_dense.size() ? m_pos : m_index->m_dense.size();
+        }
+        /// true if the current entry is taken from the dense window
+        bool from_dense() const {
+          if ( dense_pos() == m_index->m_dense.size() ) return false;
+          if ( m_sparse == m_index->m_sparse.end() ) return true;
+          return m_index->m_offset + (int)m_pos < m_sparse->first;
+        }
+
+        const BarcodeIndex*                 m_index;
+        std::size_t                         m_pos;
+        typename SparseMap::const_iterator  m_sparse;
+      };
+      friend class const_iterator;
+
+      BarcodeIndex()
+        : m_dense(), m_offset(0), m_first(0), m_dense_size(0), m_sparse() {}
+
+      /// the object with this key, or null
+      T* find( int key ) const {
+        if ( in_window(key) ) return m_dense[ key - m_offset ];
+        typename SparseMap::const_iterator i = m_sparse.find(key);
+        return ( i != m_sparse.end() ) ? i->second : 0;
+      }
+
+      /// true if there is an entry with this key
+      bool count( int key ) const { return find(key) != 0; }
+
+      /// add an entry, or replace the object of an existing one
+      void set( int key, T* obj );
+
+      /// remove the entry with this key, if any
+      void erase( int key );
+      /// remove the entry with this key only if it refers to obj
+      void erase( int key, const T* obj ) { if ( find(key) == obj ) erase(key); }
+
+      /// number of entries
+      int size() const { return m_dense_size + (int)m_sparse.size(); }
+      /// true if there are no entries
+      bool empty() const { return size() == 0; }
+      /// the largest key in use, or 0 if there is none
+      int max_key() const;
+
+      /// make room for n dense keys, e.g. before copying another index
+      void reserve( int n ) { m_dense.reserve( n ); }
+
+      /// remove all entries, keeping the allocated capacity
+      void clear() {
+        m_dense.clear();
+        m_offset = 0;
+        m_first = 0;
+        m_dense_size = 0;
+        m_sparse.clear();
+      }
+      /// swap
+      void swap( BarcodeIndex& other ) {
+        m_dense.swap( other.m_dense );
+        std::swap( m_offset, other.m_offset );
+        std::swap( m_first, other.m_first );
+        std::swap( m_dense_size, other.m_dense_size );
+        m_sparse.swap( other.m_sparse );
+      }
+
+      /// first entry
+      const_iterator begin() const {
+        return const_iterator( this, m_first, m_sparse.begin() );
+      }
+      /// past the last entry
+      const_iterator end() const {
+        return const_iterator( this, m_dense.size(), m_sparse.end() );
+      }
+
+    private: // copying is done with set()
+      BarcodeIndex( const BarcodeIndex& );
+      BarcodeIndex& operator=( const BarcodeIndex& );
+
+      bool in_window( int key ) const {
+        return key >= m_offset && !m_dense.empty()
+          && (std::size_t)( key - m_offset ) < m_dense.size();
+      }
+      /// first occupied slot at or after pos, or the end of the window
+      std::size_t next_used( std::size_t pos ) const {
+        while ( pos < m_dense.size() && !m_dense[pos] ) ++pos;
+        return pos;
+      }
+
+    private: // data members
+      std::vector<T*>      m_dense;      // objects with keys m_offset, m_offset+1, ...
+      int                  m_offset;     // key of m_dense[0]
+      std::size_t          m_first;      // first occupied slot, kept by set() and erase()
+      int                  m_dense_size; // number of occupied slots
+      SparseMap            m_sparse;     // keys outside the window
+    };
+
+    template <class T>
+    void BarcodeIndex<T>::set( int key, T* obj )
+    {
+      if ( in_window(key) ) {
+        std::size_t pos = key - m_offset;
+        if ( !m_dense[pos] ) ++m_dense_size;
+        m_dense[pos] = obj;
+        if ( pos < m_first ) m_first = pos;
+        return;
+      }
+      // keys are positive, anything else is kept aside
+      if ( key > 0 && m_dense.empty() && m_sparse.count(key) == 0 ) {
+        m_offset = key;
+        m_first = 0;
+        m_dense.push_back( obj );
+        m_dense_size = 1;
+        return;
+      }
+      // grow the window upwards as long as it stays at least half full,
+      // with a little slack so that the first few keys need not be adjacent
+      if ( key > m_offset && !m_dense.empty() ) {
+        std::size_t pos = key - m_offset;
+        if ( pos < 2*(std::size_t)m_dense_size + 16 ) {
+          std::size_t old_size = m_dense.size();
+          m_dense.resize( pos + 1, 0 );
+          // keys now covered by the window move out of the sparse map
+          typename SparseMap::iterator s = m_sparse.lower_bound( m_offset + (int)old_size );
+          while ( s != m_sparse.end() && s->first <= key ) {
+            m_dense[ s->first - m_offset ] = s->second;
+            ++m_dense_size;
+            m_sparse.erase( s++ );
+          }
+          if ( !m_dense[pos] ) ++m_dense_size;
+          m_dense[pos] = obj;
+          return;
+        }
+      }
+      m_sparse[key] = obj;
+    }
+
+    template <class T>
+    void BarcodeIndex<T>::erase( int key )
+    {
+      if ( !in_window(key) ) {
+        m_sparse.erase( key );
+        return;
+      }
+      std::size_t pos = key - m_offset;
+      if ( !m_dense[pos] ) return;
+      m_dense[pos] = 0;
+      --m_dense_size;
+      if ( m_dense_size == 0 ) {
+        // the next key starts a new window
+        m_dense.clear();
+        m_first = 0;
+      } else {
+        // keep the last slot occupied, so that max_key() is immediate
+        while ( !m_dense.back() ) m_dense.pop_back();
+        // and the first one known, so that begin() only reads; each hole
+        // is skipped once, so repeatedly erasing begin() stays linear
+        if ( pos == m_first ) m_first = next_used( pos + 1 );
+      }
+    }
+
+    template <class T>
+    int BarcodeIndex<T>::max_key() const
+    {
+      int dense_max = m_dense.empty() ? 0 : m_offset + (int)m_dense.size() - 1;
+      if ( m_sparse.empty() ) return dense_max;
+      int sparse_max = m_sparse.rbegin()->first;
+      return sparse_max > dense_max ? sparse_max : dense_max;
+    }
+
+  } // detail
+
+} // HepMC
+
+#endif  // HEPMC_BARCODE_INDEX_H
@@ -0,0 +1,91 @@
+#ifndef HEPMC_CHAIN_INDEX_H
+#define HEPMC_CHAIN_INDEX_H
+
+//////////////////////////////////////////////////////////////////////////
+// ChainIndex.h
+//
+// Copies of the same particle, for going to the first and last copy
+//////////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include <vector>
+
+namespace HepMC {
+
+  class GenEvent;
+  class GenParticle;
+
+  //! ChainIndex links every particle of an event to its other copies
+
+  ///
+  /// \class ChainIndex
+  /// Generators record a particle again every time it recoils or
+  /// radiates, so that one physical particle becomes a chain of copies.
+  /// Particle q is the next copy of particle p if q is the only particle
+  /// with the PDG id of p coming out of the end vertex of p, and p is the
+  /// only particle with that id going in.
+  ///
+  /// fill() follows all chains of the event once. first_copy() and
+  /// last_copy() are then a table lookup instead of a walk through the
+  /// end vertices, and last_copies() gives the particles of the event
+  /// with every chain collapsed to its last copy.
+  ///
+  /// Only particles of the event are taken into account. A particle which
+  /// is not a copy is its own first and last copy, and so is a particle
+  /// on a loop of copies.
+  ///
+  /// The index refers to the particles of the event, which must not change
+  /// while it is used. It is meant to be refilled for every event and keeps
+  /// its capacity.
+  ///
+  class ChainIndex {
+  public:
+    ChainIndex();
+    /// index of evt
+    explicit ChainIndex( const GenEvent& evt );
+
+    /// replace the contents by the index of evt
+    void fill( const GenEvent& evt );
+    /// forget the event, keeping the capacity
+    void clear();
+
+    /// number of particles
+    int size() const { return (int)m_particles.size(); }
+
+    /// the first copy of p, 0 if p is not a particle of the event
+    GenParticle* first_copy( const GenParticle* p ) const;
+    /// the last copy of p, 0 if p is not a particle of the event
+    GenParticle* last_copy( const GenParticle* p ) const;
+    /// the copy p comes from, or 0
+    GenParticle* previous_copy( const GenParticle* p ) const;
+    /// the copy coming from p, or 0
+    GenParticle* next_copy( const GenParticle* p ) const;
+    /// true if p is a particle of the event and its own first copy
+    bool is_first_copy( const GenParticle* p ) const { return p && first_copy( p ) == p; }
+    /// true if p is a particle of the event and its own last copy
+    bool is_last_copy( const GenParticle* p ) const { return p && last_copy( p ) == p; }
+
+    /// the last copies, in the order of GenEvent::particles_begin():
+    /// the particles of the event with every chain collapsed
+    const std::vector<GenParticle*>& last_copies() const { return m_last_copies; }
+
+  private:
+    /// position of p in GenEvent::particles_begin(), or -1
+    int particle_index( const GenParticle* p ) const;
+    GenParticle* particle( int i ) const { return i < 0 ? 0 : m_particles[i]; }
+
+  private: // data members
+    std::vector<GenParticle*>       m_particles;  // in GenEvent::particles_begin() order
+    std::vector<int>                m_previous;   // by particle, -1 if none
+    std::vector<int>                m_next;
+    std::vector<int>                m_first;
+    std::vector<int>                m_last;
+    std::vector<GenParticle*>       m_last_copies;
+    int                             m_first_key;  // barcode of m_slot[0]
+    std::vector<int>                m_slot;       // particle index by barcode, if dense
+    std::vector< std::pair<int,int> > m_sparse_slot; // otherwise, sorted by barcode
+  };
+
+} // HepMC
+
+#endif  // HEPMC_CHAIN_INDEX_H
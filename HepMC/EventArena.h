@@ -0,0 +1,70 @@
+#ifndef HEPMC_EVENT_ARENA_H
+#define HEPMC_EVENT_ARENA_H
+
+//////////////////////////////////////////////////////////////////////////
+// EventArena.h
+//
+// Block allocator for the particles and vertices of a single GenEvent
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <vector>
+
+namespace HepMC {
+
+  //! The EventArena class hands out memory for particles and vertices
+
+  ///
+  /// \class EventArena
+  /// Particles and vertices are carved out of large contiguous blocks
+  /// instead of being allocated one at a time on the heap.
+  /// Individual objects are never given back: the memory of all of them
+  /// is reclaimed at once by reset() or release(), which GenEvent does
+  /// in clear() and in its destructor.
+  ///
+  /// An EventArena is normally created and owned by a GenEvent,
+  /// see GenEvent::use_arena().
+  ///
+  class EventArena {
+  public:
+    /// blocks are at least block_size bytes long
+    explicit EventArena( std::size_t block_size = 65536 );
+    ~EventArena();
+
+    /// storage for nbytes, aligned for any particle or vertex
+    void* allocate( std::size_t nbytes );
+    /// make all blocks available again without returning them to the system
+    void reset();
+    /// return all blocks to the system
+    void release();
+
+    /// number of bytes handed out since the last reset
+    std::size_t bytes_used() const { return m_used; }
+    /// number of bytes held in blocks
+    std::size_t bytes_reserved() const { return m_reserved; }
+    /// number of blocks
+    std::size_t blocks_size() const { return m_blocks.size(); }
+
+    /// all allocations are rounded up to a multiple of this
+    static std::size_t alignment() { return 16; }
+
+  private: // copying is not allowed
+    EventArena( const EventArena& );
+    EventArena& operator=( const EventArena& );
+
+  private: // data members
+    struct Block {
+      char*        data;
+      std::size_t  size;
+    };
+    std::size_t         m_block_size;
+    std::vector<Block>  m_blocks;
+    std::size_t         m_current; // block being filled
+    std::size_t         m_offset;  // first free byte in m_blocks[m_current]
+    std::size_t         m_used;
+    std::size_t         m_reserved;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_EVENT_ARENA_H
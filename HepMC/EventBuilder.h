@@ -0,0 +1,114 @@
+#ifndef HEPMC_EVENT_BUILDER_H
+#define HEPMC_EVENT_BUILDER_H
+
+//////////////////////////////////////////////////////////////////////////
+// EventBuilder.h
+//
+// Builds a GenEvent from flat tables of particles and vertices
+//////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "HepMC/SimpleVector.h"
+
+namespace HepMC {
+
+  class GenEvent;
+  class GenVertex;
+
+  //! EventBuilder fills a GenEvent from tables of particles and vertices
+
+  ///
+  /// \class EventBuilder
+  /// Particles and vertices are first collected in two plain arrays,
+  /// in which they refer to each other by index: every particle gives
+  /// the index of its production vertex and of its end vertex, or -1
+  /// if it has none. This is the vertex form of the mother and daughter
+  /// pointers of HEPEVT (JMOHEP/JDAHEP), and the same convention as
+  /// in GenEventColumns.
+  ///
+  /// fill_event() checks the tables and then builds the whole event graph
+  /// in one pass, with the barcode indices sized in advance and without
+  /// the barcode bookkeeping done for every particle by
+  /// GenVertex::add_particle_in/out and GenEvent::add_vertex.
+  /// Particle i is the i-th outgoing particle of its production vertex
+  /// and the i-th incoming particle of its end vertex, in table order.
+  ///
+  /// A barcode of 0 stands for the default, which is i+1 for particle i
+  /// and -(j+1) for vertex j, like in IO_HEPEVT.
+  /// Momenta and positions are taken to be in the units of the event.
+  /// Flow, polarization and weights can be set afterwards in the event.
+  ///
+  /// The builder is meant to be reused for every event: clear() keeps the
+  /// capacity of the tables.
+  ///
+  class EventBuilder {
+  public:
+    EventBuilder();
+
+    /// add a vertex and return its index
+    int add_vertex( const FourVector& position, int status = 0, int barcode = 0 );
+    /// add a particle and return its index,
+    /// its generated mass is the mass of momentum
+    int add_particle( const FourVector& momentum, int pdg_id, int status,
+                      int production_vertex, int end_vertex, int barcode = 0 );
+    /// set the generated mass of particle i
+    void set_generated_mass( int i, double m ) { m_particles[i].generated_mass = m; }
+    /// set the signal process vertex, -1 for none
+    void set_signal_process_vertex( int j ) { m_signal_process_vertex = j; }
+    /// set the beam particles, -1 for none
+    void set_beam_particles( int i1, int i2 ) { m_beam_particle_1 = i1; m_beam_particle_2 = i2; }
+
+    /// make room for nparticles particles and nvertices vertices
+    void reserve( int nparticles, int nvertices );
+    /// remove all particles and vertices, keeping the capacity
+    void clear();
+
+    /// number of particles
+    int particles_size() const { return (int)m_particles.size(); }
+    /// number of vertices
+    int vertices_size() const { return (int)m_vertices.size(); }
+
+    /// true if the tables describe a valid event
+    bool is_valid() const { return check() == 0; }
+    /// Replace the contents of evt by the event described by the tables.
+    /// evt is cleared first, so its event number etc. are set afterwards.
+    /// Returns false and leaves evt unchanged if the tables are not valid.
+    bool fill_event( GenEvent* evt ) const;
+
+  private:
+    struct Particle {
+      FourVector momentum;
+      double     generated_mass;
+      int        pdg_id;
+      int        status;
+      int        production_vertex;
+      int        end_vertex;
+      int        barcode;
+    };
+    struct Vertex {
+      FourVector position;
+      int        status;
+      int        barcode;
+    };
+
+    /// the first problem found in the tables, or null
+    const char* check() const;
+    int particle_barcode( int i ) const
+    { return m_particles[i].barcode ? m_particles[i].barcode : i+1; }
+    int vertex_barcode( int j ) const
+    { return m_vertices[j].barcode ? m_vertices[j].barcode : -(j+1); }
+
+  private: // data members
+    std::vector<Particle>  m_particles;
+    std::vector<Vertex>    m_vertices;
+    int                    m_signal_process_vertex;
+    int                    m_beam_particle_1;
+    int                    m_beam_particle_2;
+    mutable std::vector<GenVertex*>  m_vertex_objects; // vertex of each index while filling
+    mutable std::vector<int>         m_barcodes;       // for the uniqueness check
+  };
+
+} // HepMC
+
+#endif  // HEPMC_EVENT_BUILDER_H
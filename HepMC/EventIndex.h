@@ -0,0 +1,92 @@
+#ifndef HEPMC_EVENT_INDEX_H
+#define HEPMC_EVENT_INDEX_H
+
+//////////////////////////////////////////////////////////////////////////
+// EventIndex.h
+//
+// Positions of the events of an IO_GenEvent file, for random access
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace HepMC {
+
+  //! EventIndex holds where every event of an IO_GenEvent file starts
+
+  ///
+  /// \class EventIndex
+  /// Entry n of the index is the n-th event of the file, counted from 0:
+  /// the byte offset of its "E" line, the type of the listing it is in,
+  /// and its event number and numbers of vertices and particles.
+  /// IO_GenEvent::seek_to_event() goes straight to an entry, so that an
+  /// event far into a file is read without reading those before it, and
+  /// split() cuts a file into parts of about the same size for several
+  /// jobs.
+  ///
+  /// The index is built by scanning a file with build(), which only looks
+  /// at the first character of most lines, or while the file is written
+  /// by IO_GenEvent (see IO_GenEvent::record_index). It is kept in a file
+  /// of its own next to the event file with write(), as one line per
+  /// event between the lines
+  ///  "HepMC::EventIndex-START_EVENT_INDEX" and
+  ///  "HepMC::EventIndex-END_EVENT_INDEX".
+  /// Offsets beyond 2 GB need a 64 bit long.
+  ///
+  class EventIndex {
+  public:
+    /// where an event starts, and what is in it
+    struct Entry {
+      std::streamoff offset;        // of the "E" line
+      int            io_type;       // of the listing, see known_io in StreamInfo.h
+      bool           has_key;       // false if the listing has no start key
+      int            event_number;
+      int            vertices;
+      int            particles;
+    };
+
+    EventIndex();
+    /// index of the events of is, read from its current position to its end
+    explicit EventIndex( std::istream& is );
+
+    /// replace the contents by the index of the events of is, read from
+    /// its current position to its end; the offsets count from the start
+    /// of is. False if is cannot tell its position.
+    bool build( std::istream& is );
+    /// add the next event
+    void add( const Entry& entry );
+    /// forget all events, keeping the capacity
+    void clear();
+
+    /// number of events
+    std::size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+    /// the n-th event of the file
+    const Entry& operator[]( std::size_t n ) const { return m_entries[n]; }
+
+    /// position n of the first event with this event number, false if
+    /// there is none
+    bool find( int event_number, std::size_t& n ) const;
+    /// the first event of part k when the events are cut into nparts
+    /// parts in file order, with about the same number of particles in
+    /// every part; split( nparts, nparts ) is size()
+    std::size_t split( int k, int nparts ) const;
+
+    /// write the index
+    std::ostream& write( std::ostream& os ) const;
+    /// replace the contents by an index written by write(), false if
+    /// the input is not an index
+    bool read( std::istream& is );
+
+  private: // data members
+    std::vector<Entry>   m_entries;
+    bool                 m_ordered;   // the event numbers do not decrease
+  };
+
+} // HepMC
+
+#endif  // HEPMC_EVENT_INDEX_H
@@ -0,0 +1,122 @@
+#ifndef HEPMC_EVENT_PARTITION_H
+#define HEPMC_EVENT_PARTITION_H
+
+//////////////////////////////////////////////////////////////////////////
+// EventPartition.h
+//
+// Independent parts of an event, for working on them in parallel
+//////////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include <vector>
+
+namespace HepMC {
+
+  class GenEvent;
+  class GenParticle;
+  class GenVertex;
+
+  //! EventPartition splits an event into parts which are not connected
+
+  ///
+  /// \class EventPartition
+  /// fill() splits the vertices and particles of an event into connected
+  /// parts: two vertices are in the same part if a chain of particles
+  /// joins them, whatever the direction of the particles. In heavy ion
+  /// and pile-up events, every collision and the decays below it are
+  /// usually a part of their own.
+  /// Part k holds its vertices in the order of GenEvent::vertices_begin()
+  /// and its particles in the order of GenEvent::particles_begin(), and
+  /// the parts are numbered in the order of their first vertex.
+  ///
+  /// for_each() hands every part to a Visitor, on several threads.
+  /// It first calls GenEvent::begin_shared_reading, so the visitor may use
+  /// all const functions of the event, its vertices and particles, and
+  /// walk through its part with the iterators of GenVertex. A visitor may
+  /// call for_each() again.
+  ///
+  /// The partition refers to the particles and vertices of the event,
+  /// which must not change while it is used. It is meant to be refilled
+  /// for every event and keeps its capacity.
+  ///
+  class EventPartition {
+  public:
+    /// the vertices and particles of one part
+    class Part {
+    public:
+      typedef GenVertex* const*   vertex_const_iterator;
+      typedef GenParticle* const* particle_const_iterator;
+
+      Part( int index = -1,
+            vertex_const_iterator vb = 0, vertex_const_iterator ve = 0,
+            particle_const_iterator pb = 0, particle_const_iterator pe = 0 )
+        : m_index(index), m_vertices_begin(vb), m_vertices_end(ve),
+          m_particles_begin(pb), m_particles_end(pe) {}
+
+      /// number of the part
+      int index() const { return m_index; }
+      vertex_const_iterator vertices_begin() const { return m_vertices_begin; }
+      vertex_const_iterator vertices_end() const { return m_vertices_end; }
+      int vertices_size() const { return (int)( m_vertices_end - m_vertices_begin ); }
+      particle_const_iterator particles_begin() const { return m_particles_begin; }
+      particle_const_iterator particles_end() const { return m_particles_end; }
+      int particles_size() const { return (int)( m_particles_end - m_particles_begin ); }
+
+    private:
+      int                     m_index;
+      vertex_const_iterator   m_vertices_begin;
+      vertex_const_iterator   m_vertices_end;
+      particle_const_iterator m_particles_begin;
+      particle_const_iterator m_particles_end;
+    };
+
+    /// what for_each() does with every part
+    class Visitor {
+    public:
+      virtual ~Visitor() {}
+      /// called once for every part, by any of the threads,
+      /// for several parts at the same time
+      virtual void visit( const Part& part ) = 0;
+    };
+
+    EventPartition();
+    /// partition of evt
+    explicit EventPartition( const GenEvent& evt );
+
+    /// replace the contents by the partition of evt
+    void fill( const GenEvent& evt );
+    /// forget the event, keeping the capacity
+    void clear();
+
+    /// number of parts
+    int size() const { return (int)m_vertex_offsets.size() - 1; }
+    /// part k
+    Part part( int k ) const;
+    /// number of the part of v, -1 if v is not a vertex of the event
+    int part_of( const GenVertex* v ) const;
+
+    /// visit every part on nthreads threads, the calling thread included,
+    /// and return when all parts have been visited. The largest parts are
+    /// handed out first. Visitor::visit must not throw.
+    /// Without POSIX threads (on Windows) the parts are visited one after
+    /// the other.
+    void for_each( Visitor& visitor, int nthreads ) const;
+
+  private:
+    /// position of v in GenEvent::vertices_begin(), or -1
+    int vertex_index( const GenVertex* v ) const;
+
+  private: // data members
+    const GenEvent*                 m_event;
+    std::vector<GenVertex*>         m_vertices;        // by part
+    std::vector<int>                m_vertex_offsets;  // part k: m_vertices[m_vertex_offsets[k]] ...
+    std::vector<GenParticle*>       m_particles;       // by part
+    std::vector<int>                m_particle_offsets;
+    std::vector<int>                m_part;            // by vertex in vertices_begin() order
+    std::vector< std::pair<const GenVertex*,int> > m_vertex_index; // sorted by vertex
+    std::vector<int>                m_by_size;         // parts, largest first
+  };
+
+} // HepMC
+
+#endif  // HEPMC_EVENT_PARTITION_H
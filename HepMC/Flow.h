@@ -47,8 +47,9 @@
 //
 
 #include <iostream>
-#include <map>
 #include <vector>
+#include <utility>
+#include "HepMC/HepMCDefs.h"
 
 namespace HepMC {
 
@@ -62,6 +63,10 @@ namespace HepMC {
   /// keeps track of an arbitrary number of flow patterns within a graph
   /// (i.e. color flow, charge flow, lepton number flow, ...)
   /// Flow patterns are coded with an integer, in the same manner as in Herwig.
+  ///
+  /// The (code_index,icode) pairs are kept sorted by code index.
+  /// Up to two of them -- the colour codes of a parton -- are stored inside
+  /// the Flow object itself, only longer patterns allocate.
   class Flow {
 
     /// for printing
@@ -77,6 +82,18 @@ namespace HepMC {
     void swap( Flow & other);
     /// make a copy
     Flow&           operator=( const Flow& );
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+    /// move, like the copy this takes over the particle_owner
+    Flow( Flow&& inflow ) noexcept
+      : m_particle_owner(inflow.m_particle_owner), m_more(0), m_size(0)
+    { swap_codes( inflow ); }
+    /// move only the flow codes ... not the particle_owner
+    Flow&           operator=( Flow&& inflow ) noexcept {
+      clear();
+      swap_codes( inflow );
+      return *this;
+    }
+#endif
     /// equality
     bool            operator==( const Flow& a ) const; //compares only flow
     /// inequality
@@ -87,6 +104,7 @@ namespace HepMC {
 
     /// returns all connected particles which have "code" in any  of the
     ///  num_indices beginning with index code_index.
+    /// For many particles of the same event, FlowIndex is much faster.
     std::vector<HepMC::GenParticle*> connected_partners( int code, int code_index =1,
                                                          int num_indices = 2 ) const;
     /// same as connected_partners, but returns only those particles which
@@ -121,10 +139,18 @@ namespace HepMC {
     /// empty flow pattern container
     bool            erase( int code_index );
 
-    /// iterator for flow pattern container
-    typedef std::map<int,int>::iterator       iterator;
-    /// const iterator for flow pattern container
-    typedef std::map<int,int>::const_iterator const_iterator;
+    /// a flow pattern, (code_index,icode)
+    typedef std::pair<int,int>   value_type;
+    /// @brief iterator for flow pattern container
+    ///
+    /// Before HepMC 2.07 this was std::map<int,int>::iterator.  It is now a
+    /// pointer into the sorted patterns: it->first and it->second work as
+    /// before, but code which names the map iterator type must use
+    /// Flow::iterator instead, and the code index must not be modified
+    /// through it.
+    typedef value_type*          iterator;
+    /// const iterator for flow pattern container, see iterator
+    typedef const value_type*    const_iterator;
     /// beginning of flow pattern container
     iterator            begin();
     /// end of flow pattern container
@@ -148,8 +174,18 @@ namespace HepMC {
                                                  int code, int code_index,
                                                  int num_indices ) const;
   private:
-    GenParticle*         m_particle_owner;
-    std::map<int,int> m_icode; // stores flow patterns as(code_index,icode)
+    /// exchange the flow codes, not the particle_owner
+    void            swap_codes( Flow& other );
+    /// the pattern with this code index, or null
+    const value_type* find( int code_index ) const;
+
+    /// number of patterns stored inline
+    static const int inline_size = 2;
+
+    GenParticle*              m_particle_owner;
+    std::vector<value_type>*  m_more;   // all patterns, when they do not fit inline
+    value_type                m_inline[inline_size];
+    int                       m_size;   // number of patterns in m_inline
   };
 
   ///////////////////////////
@@ -159,31 +195,27 @@ namespace HepMC {
   inline const GenParticle* Flow::particle_owner() const {
     return m_particle_owner;
   }
-  inline int Flow::icode( int code_index ) const {
-    std::map<int,int>::const_iterator a = m_icode.find(code_index);
-    return a==m_icode.end() ? 0 : (*a).second;
+  inline const Flow::value_type* Flow::find( int code_index ) const {
+    for ( const_iterator a = begin(); a != end(); ++a ) {
+      if ( a->first == code_index ) return a;
+    }
+    return 0;
   }
-  inline Flow Flow::set_icode( int code_index, int code ) {
-    m_icode[code_index] = code;
-    return *this;
+  inline int Flow::icode( int code_index ) const {
+    const value_type* a = find( code_index );
+    return a ? a->second : 0;
   }
   inline Flow Flow::set_unique_icode( int flow_num ) {
     /// use this method if you want to assign a unique flow code, but
     /// do not want the burden of choosing it yourself
-    m_icode[flow_num] = size_t(this);
-    return *this;
-  }
-  inline bool Flow::empty() const { return (bool)m_icode.empty(); }
-  inline int Flow::size() const { return (int)m_icode.size(); }
-  inline void Flow::clear() { m_icode.clear(); }
-  inline bool Flow::erase( int code_index ) {
-    // this will return true if the number of elements removed is nonzero
-    return m_icode.erase( code_index )==0 ? false : true ;
+    return set_icode( flow_num, size_t(this) );
   }
-  inline Flow::iterator Flow::begin() { return m_icode.begin(); }
-  inline Flow::iterator Flow::end() { return m_icode.end(); }
-  inline Flow::const_iterator Flow::begin() const { return m_icode.begin(); }
-  inline Flow::const_iterator Flow::end() const { return m_icode.end(); }
+  inline bool Flow::empty() const { return size() == 0; }
+  inline int Flow::size() const { return m_more ? (int)m_more->size() : m_size; }
+  inline Flow::iterator Flow::begin() { return m_more ? &(*m_more)[0] : m_inline; }
+  inline Flow::iterator Flow::end() { return begin() + size(); }
+  inline Flow::const_iterator Flow::begin() const { return m_more ? &(*m_more)[0] : m_inline; }
+  inline Flow::const_iterator Flow::end() const { return begin() + size(); }
 
   ///////////////////////////
   // INLINE Operators      //
@@ -191,19 +223,28 @@ namespace HepMC {
 
   inline bool Flow::operator==( const Flow& a ) const {
     /// equivalent flows have the same flow codes for all flow_numbers
-    /// (i.e. their m_icode maps are identical), but they need not have the
+    /// (i.e. their flow codes are identical), but they need not have the
     /// same m_particle owner
-    return (m_icode == a.m_icode);
+    if ( size() != a.size() ) return false;
+    for ( const_iterator i = begin(), j = a.begin(); i != end(); ++i, ++j ) {
+      if ( *i != *j ) return false;
+    }
+    return true;
   }
   inline bool Flow::operator!=( const Flow& a ) const {
     return !( *this == a );
   }
   inline Flow& Flow::operator=( const Flow& inflow ) {
-    /// copies only the m_icode ... not the particle_owner
+    /// copies only the flow codes ... not the particle_owner
     /// this is intuitive behaviour so you can do
     /// oneparticle->flow() = otherparticle->flow()
     //
-    m_icode = inflow.m_icode;
+    if ( this != &inflow ) {
+      clear();
+      for ( const_iterator a = inflow.begin(); a != inflow.end(); ++a ) {
+        set_icode( a->first, a->second );
+      }
+    }
     return *this;
   }
 
@@ -0,0 +1,106 @@
+#ifndef HEPMC_FLOW_INDEX_H
+#define HEPMC_FLOW_INDEX_H
+
+//////////////////////////////////////////////////////////////////////////
+// FlowIndex.h
+//
+// Flow codes of all particles of an event, for finding flow partners
+//////////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include <vector>
+
+namespace HepMC {
+
+  class GenEvent;
+  class GenParticle;
+  class GenVertex;
+
+  //! FlowIndex finds the flow partners of the particles of an event
+
+  ///
+  /// \class FlowIndex
+  /// fill() collects the flow codes of all particles of an event once,
+  /// sorted by code and code index. connected_partners() and
+  /// dangling_connected_partners() then give the same particles as the
+  /// functions of the same name of Flow, but only look at the particles
+  /// which carry the code: they are joined through the vertices they share,
+  /// instead of walking the family of every vertex on the flow line and
+  /// searching the result so far for every particle found.
+  /// The time taken grows with the number of particles carrying the code,
+  /// which is usually the length of the flow line.
+  ///
+  /// The partners are returned in the order of GenEvent::particles_begin(),
+  /// and only particles of the event are taken into account.
+  /// Code 0, which stands for no code, has no partners.
+  ///
+  /// The index refers to the particles of the event, which must not change
+  /// while it is used. It is meant to be refilled for every event and keeps
+  /// its capacity.
+  ///
+  class FlowIndex {
+  public:
+    FlowIndex();
+    /// index of evt
+    explicit FlowIndex( const GenEvent& evt );
+
+    /// replace the contents by the index of evt
+    void fill( const GenEvent& evt );
+    /// forget the event, keeping the capacity
+    void clear();
+
+    /// number of (particle, code index, code) entries
+    int size() const { return (int)m_entries.size(); }
+
+    /// all particles connected to p which have code in any of the
+    /// num_indices code indices beginning with code_index, p included,
+    /// see Flow::connected_partners()
+    std::vector<GenParticle*> connected_partners( const GenParticle* p, int code,
+                                                  int code_index = 1,
+                                                  int num_indices = 2 ) const;
+    /// the particles of connected_partners() which are connected to at most
+    /// one other particle, see Flow::dangling_connected_partners()
+    std::vector<GenParticle*> dangling_connected_partners( const GenParticle* p, int code,
+                                                           int code_index = 1,
+                                                           int num_indices = 2 ) const;
+
+  private:
+    struct Entry {
+      int          code;
+      int          code_index;
+      int          position;    // in GenEvent::particles_begin()
+      GenParticle* particle;
+      bool operator<( const Entry& b ) const {
+        if ( code != b.code ) return code < b.code;
+        if ( code_index != b.code_index ) return code_index < b.code_index;
+        return position < b.position;
+      }
+    };
+    /// a particle carrying the code, while answering a question
+    struct Node {
+      int          position;
+      int          matches;     // number of code indices with the code
+      GenParticle* particle;
+      bool operator<( const Node& b ) const { return position < b.position; }
+    };
+    typedef std::pair<const GenVertex*,int> Attachment; // vertex, node
+
+    /// collect the particles connected to p in m_nodes and mark them
+    /// in m_reached, false if p does not carry the code
+    bool connect( const GenParticle* p, int code, int code_index,
+                  int num_indices ) const;
+
+  private: // data members
+    const GenEvent*          m_event;
+    std::vector<Entry>       m_entries;   // sorted
+    // work space of connect()
+    mutable std::vector<Node>        m_nodes;       // sorted by position
+    mutable std::vector<Attachment>  m_attached;    // sorted by vertex
+    mutable std::vector<int>         m_total;       // matches at the vertex of m_attached[k]
+    mutable std::vector<char>        m_reached;     // by node
+    mutable std::vector<int>         m_queue;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_FLOW_INDEX_H
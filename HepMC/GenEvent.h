@@ -9,11 +9,13 @@
 #include "HepMC/PdfInfo.h"
 #include "HepMC/Units.h"
 #include "HepMC/HepMCDefs.h"
+#include "HepMC/BarcodeIndex.h"
 #include <map>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <utility>
 
 //////////////////////////////////////////////////////////////////////////
 // Matt.Dobbs@Cern.CH, September 1999, refer to:
@@ -139,6 +141,8 @@ namespace HepMC {
 
 namespace HepMC {
 
+  class EventArena;
+
   struct GenEventVertexRange;
   struct ConstGenEventVertexRange;
   struct GenEventParticleRange;
@@ -151,9 +155,17 @@ namespace HepMC {
   /// HepMC::GenEvent contains information about generated particles.
   /// GenEvent is structured as a set of vertices which contain the particles.
   ///
+  /// With deferred barcodes (see defer_barcodes()) the barcode indices are
+  /// completed by the first const access which needs them, so a const
+  /// GenEvent may still fill its indices; begin_shared_reading() does it
+  /// up front.
+  ///
   class GenEvent {
     friend class GenParticle;
     friend class GenVertex;
+    friend class EventBuilder;
+    friend class GenEventCompact;
+    friend class GenVertex::vertex_iterator;
   public:
     /// default constructor creates null pointers to HeavyIon, PdfInfo, and GenCrossSection
     GenEvent( int signal_process_id = 0, int event_number = 0,
@@ -183,6 +195,18 @@ namespace HepMC {
               const HeavyIon& ion, const PdfInfo& pdf );
     GenEvent( const GenEvent& inevent );          //!< deep copy
     GenEvent& operator=( const GenEvent& inevent ); //!< make a deep copy
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+    /// move: takes over the vertices and particles of inevent,
+    /// which is left empty
+    GenEvent( GenEvent&& inevent ) noexcept : GenEvent() { swap( inevent ); }
+    /// move: takes over the vertices and particles of inevent,
+    /// which is left empty
+    GenEvent& operator=( GenEvent&& inevent ) noexcept {
+      GenEvent tmp( std::move( inevent ) );
+      swap( tmp );
+      return *this;
+    }
+#endif
     virtual ~GenEvent(); //!<deletes all vertices/particles in this evt
 
     void swap( GenEvent & other );  //!< swap
@@ -216,7 +240,8 @@ namespace HepMC {
     /// QED coupling, see hep-ph/0109068
     /// @todo Ambiguous. Remove?
     double alphaQED() const { return m_alphaQED; }
-    /// Pointer to the vertex containing the signal process
+    /// Pointer to the vertex containing the signal process,
+    /// null once the vertex has left the event
     GenVertex* signal_process_vertex() const { return m_signal_process_vertex; }
     /// Test to see if we have two valid beam particles
     bool valid_beam_particles() const;
@@ -228,6 +253,7 @@ namespace HepMC {
     std::vector<HepMC::GenParticle*> beams() const;
     /// check GenEvent for validity
     /// A GenEvent is presumed valid if it has particles and/or vertices.
+    /// @note IntegrityCheck looks at the consistency of the whole event.
     bool is_valid() const;
 
     /// @name Event weights
@@ -305,6 +331,123 @@ namespace HepMC {
     /// Empties the entire event
     void clear();
 
+    /// @name Particle and vertex allocation
+    //@{
+
+    /// @brief Allocate the particles and vertices of this event from an arena
+    ///
+    /// With the arena switched on, create_particle() and create_vertex() --
+    /// and therefore the streaming input, IO_HEPEVT and the copy constructor --
+    /// carve new objects out of large blocks owned by this event.
+    /// The blocks are reclaimed all at once by clear() and by the destructor,
+    /// so arena objects must not outlive the event nor be moved to another
+    /// event. Deleting one of them individually is allowed, as usual.
+    void use_arena( bool on = true ) { m_use_arena = on; }
+    /// True if new particles and vertices are taken from the arena
+    bool uses_arena() const { return m_use_arena; }
+
+    /// @brief Keep the particles and vertices of this event for reuse
+    ///
+    /// With recycling switched on, clear() does not delete the particles
+    /// and vertices of the event but keeps them, together with the capacity
+    /// of their containers, for create_particle() and create_vertex().
+    /// An event which is read or copied over and over again then stops
+    /// allocating once it has seen its largest event.
+    /// The kept objects are deleted when recycling is switched off
+    /// and by the destructor.
+    void recycle_objects( bool on = true );
+    /// True if clear() keeps the particles and vertices for reuse
+    bool recycles_objects() const { return m_recycle; }
+    /// Number of particles kept for reuse
+    int recycled_particles_size() const { return (int)m_free_particles.size(); }
+    /// Number of vertices kept for reuse
+    int recycled_vertices_size() const { return (int)m_free_vertices.size(); }
+
+    /// A new particle, not yet attached to this event
+    GenParticle* create_particle();
+    /// A new particle, not yet attached to this event
+    GenParticle* create_particle( const FourVector& momentum, int pdg_id,
+                                  int status = 0 );
+    /// A shallow copy of a particle, not yet attached to this event
+    GenParticle* create_particle( const GenParticle& inparticle );
+    /// A new vertex, not yet attached to this event
+    GenVertex* create_vertex( const FourVector& position = FourVector(0,0,0,0),
+                              int status = 0,
+                              const WeightContainer& weights = std::vector<double>() );
+
+    //@}
+
+    /// @name Barcode assignment
+    //@{
+
+    /// @brief Defer the automatic barcodes to the first time they are needed
+    ///
+    /// Normally a particle or vertex without a suggested barcode gets the
+    /// next free barcode as soon as it comes into the event, which costs
+    /// a few lookups in the barcode index every time.
+    /// With deferred barcodes such objects only join a list, and all of them
+    /// get their barcode together the first time the barcode of one of them
+    /// is asked for, or the event is iterated, looked up by barcode, counted,
+    /// written, copied or cleared. Building an event is then linear in its
+    /// size, and so is removing objects which are still waiting, since each
+    /// of them knows its place in the list.
+    /// Suggested barcodes are still taken immediately.
+    /// The automatic barcodes follow the order in which the objects were
+    /// added, but may differ from the ones given without deferring when
+    /// suggested and automatic barcodes are mixed.
+    /// Switching deferring off assigns the waiting barcodes.
+    void defer_barcodes( bool on = true );
+    /// True if automatic barcodes are deferred
+    bool defers_barcodes() const { return m_defer_barcodes; }
+    /// Give the particles and vertices waiting for a barcode their barcode now
+    void assign_barcodes() const {
+      if ( !m_deferred_particles.empty() || !m_deferred_vertices.empty() ) {
+        assign_deferred_barcodes_();
+      }
+    }
+
+    //@}
+
+    /// @name Causal order
+    //@{
+
+    /// @brief All vertices of the event, every vertex after the vertices
+    /// its incoming particles come from
+    ///
+    /// The vertices are sorted by GenVertex::depth(), and vertices of the
+    /// same depth come in the order of vertices_begin(), so that a single
+    /// pass over the list visits the event generation by generation.
+    /// Vertices on a loop, which a valid event does not have, come last.
+    /// The order is worked out when it is first asked for and kept until
+    /// particles or vertices are added to or removed from the event.
+    /// Like the deferred barcodes, it must not be worked out by several
+    /// threads at the same time, see begin_shared_reading().
+    const std::vector<GenVertex*>& ordered_vertices() const {
+      if ( !m_vertex_order_valid ) order_vertices_();
+      return m_vertex_order;
+    }
+
+    //@}
+
+    /// @name Reading from several threads
+    //@{
+
+    /// @brief Let several threads read the event at once
+    ///
+    /// Some const functions keep work for later: deferred barcodes and the
+    /// causal order are worked out when first needed.
+    /// begin_shared_reading() does the outstanding work now.
+    /// As long as the event does not change, the const functions of the
+    /// event, its vertices and its particles, and the iterators, then only
+    /// read the event, and any number of threads may use them.
+    /// Call it on one thread before the others start; once the work is
+    /// done, further calls only read the event too, so a thread may call it
+    /// again (e.g. through a nested EventPartition::for_each()).
+    /// Nothing needs to be called at the end.
+    void begin_shared_reading() const;
+
+    //@}
+
     /// Set unique signal process id
     void set_signal_process_id( int id ) { m_signal_process_id = id; }
     /// Set event number
@@ -399,28 +542,27 @@ namespace HepMC {
     class vertex_const_iterator : public std::iterator<std::forward_iterator_tag,HepMC::GenVertex*,ptrdiff_t> {
     public:
       /// constructor requiring vertex information
-      vertex_const_iterator(const std::map<int,HepMC::GenVertex*,std::greater<int> >::const_iterator& i) : m_map_iterator(i) {}
+      vertex_const_iterator(const detail::BarcodeIndex<HepMC::GenVertex>::const_iterator& i) : m_index_iterator(i) {}
       vertex_const_iterator() {}
       /// copy constructor
       vertex_const_iterator( const vertex_const_iterator& i ) { *this = i; }
       virtual ~vertex_const_iterator() {}
       /// make a copy
-      vertex_const_iterator&  operator=( const vertex_const_iterator& i ) { m_map_iterator = i.m_map_iterator; return *this; }
+      vertex_const_iterator&  operator=( const vertex_const_iterator& i ) { m_index_iterator = i.m_index_iterator; return *this; }
       /// return a pointer to a GenVertex
-      GenVertex* operator*(void) const { return m_map_iterator->second; }
+      GenVertex* operator*(void) const { return *m_index_iterator; }
       /// Pre-fix increment
-      vertex_const_iterator&  operator++(void) { ++m_map_iterator; return *this; }
+      vertex_const_iterator&  operator++(void) { ++m_index_iterator; return *this; }
       /// Post-fix increment
       vertex_const_iterator   operator++(int){ vertex_const_iterator out(*this); ++(*this); return out; }
       /// equality
-      bool operator==( const vertex_const_iterator& a ) const { return m_map_iterator == a.m_map_iterator; }
+      bool operator==( const vertex_const_iterator& a ) const { return m_index_iterator == a.m_index_iterator; }
       /// inequality
-      bool operator!=( const vertex_const_iterator& a ) const { return !(m_map_iterator == a.m_map_iterator); }
+      bool operator!=( const vertex_const_iterator& a ) const { return !(m_index_iterator == a.m_index_iterator); }
 
     protected:
-      /// const iterator to a vertex map
-      std::map<int,HepMC::GenVertex*,std::greater<int> >::const_iterator
-      m_map_iterator;
+      /// const iterator to the vertex index
+      detail::BarcodeIndex<HepMC::GenVertex>::const_iterator m_index_iterator;
 
     private:
       /// Pre-fix increment -- is not allowed
@@ -431,9 +573,9 @@ namespace HepMC {
 
     friend class vertex_const_iterator;
     /// begin vertex iteration
-    vertex_const_iterator vertices_begin() const { return GenEvent::vertex_const_iterator(m_vertex_barcodes.begin() ); }
+    vertex_const_iterator vertices_begin() const { assign_barcodes(); return GenEvent::vertex_const_iterator(m_vertex_barcodes.begin() ); }
     /// end vertex iteration
-    vertex_const_iterator vertices_end() const { return GenEvent::vertex_const_iterator(m_vertex_barcodes.end() ); }
+    vertex_const_iterator vertices_end() const { assign_barcodes(); return GenEvent::vertex_const_iterator(m_vertex_barcodes.end() ); }
 
 
     /// Non-const vertex iterator
@@ -442,32 +584,32 @@ namespace HepMC {
     class vertex_iterator : public std::iterator<std::forward_iterator_tag, HepMC::GenVertex*, ptrdiff_t> {
     public:
       /// constructor requiring vertex information
-      vertex_iterator(const std::map<int,HepMC::GenVertex*,std::greater<int> >::iterator& i )
-        : m_map_iterator( i ) {}
+      vertex_iterator(const detail::BarcodeIndex<HepMC::GenVertex>::const_iterator& i )
+        : m_index_iterator( i ) {}
       vertex_iterator() {}
       /// copy constructor
       vertex_iterator( const vertex_iterator& i ) { *this = i; }
       virtual ~vertex_iterator() {}
       /// make a copy
       vertex_iterator& operator=( const vertex_iterator& i ) {
-        m_map_iterator = i.m_map_iterator;
+        m_index_iterator = i.m_index_iterator;
         return *this;
       }
       /// const vertex iterator
-      operator vertex_const_iterator() const { return vertex_const_iterator(m_map_iterator); }
+      operator vertex_const_iterator() const { return vertex_const_iterator(m_index_iterator); }
       /// return a pointer to a GenVertex
-      GenVertex* operator*() const { return m_map_iterator->second; }
+      GenVertex* operator*() const { return *m_index_iterator; }
       /// Pre-fix increment
-      vertex_iterator& operator++() { ++m_map_iterator; return *this; }
+      vertex_iterator& operator++() { ++m_index_iterator; return *this; }
       /// Post-fix increment
       vertex_iterator operator++(int)    { vertex_iterator out(*this); ++(*this); return out; }
       /// equality
-      bool operator==( const vertex_iterator& a ) const { return m_map_iterator == a.m_map_iterator; }
+      bool operator==( const vertex_iterator& a ) const { return m_index_iterator == a.m_index_iterator; }
       /// inequality
-      bool operator!=( const vertex_iterator& a ) const { return !(m_map_iterator == a.m_map_iterator); }
+      bool operator!=( const vertex_iterator& a ) const { return !(m_index_iterator == a.m_index_iterator); }
     protected:
-      /// iterator to the vertex map
-      std::map<int,HepMC::GenVertex*,std::greater<int> >::iterator m_map_iterator;
+      /// iterator to the vertex index
+      detail::BarcodeIndex<HepMC::GenVertex>::const_iterator m_index_iterator;
     private:
       /// Pre-fix increment
       vertex_iterator&  operator--(void);
@@ -477,9 +619,9 @@ namespace HepMC {
     };
     friend class vertex_iterator;
     /// begin vertex iteration
-    vertex_iterator vertices_begin() { return GenEvent::vertex_iterator(m_vertex_barcodes.begin() ); }
+    vertex_iterator vertices_begin() { assign_barcodes(); return GenEvent::vertex_iterator(m_vertex_barcodes.begin() ); }
     /// end vertex iteration
-    vertex_iterator vertices_end() { return GenEvent::vertex_iterator(m_vertex_barcodes.end() ); }
+    vertex_iterator vertices_end() { assign_barcodes(); return GenEvent::vertex_iterator(m_vertex_barcodes.end() ); }
 
 
     ///////////////////////////////
@@ -497,26 +639,26 @@ namespace HepMC {
     /// Used to iterate over all particles in the event.
     class particle_const_iterator : public std::iterator<std::forward_iterator_tag,HepMC::GenParticle*,ptrdiff_t> {
     public:
-      particle_const_iterator(const std::map<int,HepMC::GenParticle*>::const_iterator& i ) : m_map_iterator(i) {}
+      particle_const_iterator(const detail::BarcodeIndex<HepMC::GenParticle>::const_iterator& i ) : m_index_iterator(i) {}
       particle_const_iterator() {}
       /// copy constructor
       particle_const_iterator( const particle_const_iterator& i ) { *this = i; }
       virtual ~particle_const_iterator() {}
       /// make a copy
-      particle_const_iterator& operator=(const particle_const_iterator& i ) { m_map_iterator = i.m_map_iterator; return *this; }
+      particle_const_iterator& operator=(const particle_const_iterator& i ) { m_index_iterator = i.m_index_iterator; return *this; }
       /// return a pointer to GenParticle
-      GenParticle* operator*(void) const { return m_map_iterator->second; }
+      GenParticle* operator*(void) const { return *m_index_iterator; }
       /// Pre-fix increment
-      particle_const_iterator& operator++(void) { ++m_map_iterator; return *this; }
+      particle_const_iterator& operator++(void) { ++m_index_iterator; return *this; }
       /// Post-fix increment
       particle_const_iterator operator++(int) { particle_const_iterator out(*this); ++(*this); return out; }
       /// equality
-      bool operator==( const particle_const_iterator& a ) const { return m_map_iterator == a.m_map_iterator; }
+      bool operator==( const particle_const_iterator& a ) const { return m_index_iterator == a.m_index_iterator; }
       /// inequality
-      bool operator!=( const particle_const_iterator& a ) const { return !(m_map_iterator == a.m_map_iterator); }
+      bool operator!=( const particle_const_iterator& a ) const { return !(m_index_iterator == a.m_index_iterator); }
     protected:
-      /// const iterator to the GenParticle map
-      std::map<int,HepMC::GenParticle*>::const_iterator m_map_iterator;
+      /// const iterator to the GenParticle index
+      detail::BarcodeIndex<HepMC::GenParticle>::const_iterator m_index_iterator;
     private:
       /// Pre-fix increment
       particle_const_iterator&  operator--(void);
@@ -526,9 +668,9 @@ namespace HepMC {
 
     friend class particle_const_iterator;
     /// begin particle iteration
-    particle_const_iterator particles_begin() const { return GenEvent::particle_const_iterator(m_particle_barcodes.begin() ); }
+    particle_const_iterator particles_begin() const { assign_barcodes(); return GenEvent::particle_const_iterator(m_particle_barcodes.begin() ); }
     /// end particle iteration
-    particle_const_iterator particles_end() const { return GenEvent::particle_const_iterator(m_particle_barcodes.end() ); }
+    particle_const_iterator particles_end() const { assign_barcodes(); return GenEvent::particle_const_iterator(m_particle_barcodes.end() ); }
 
 
     /// Non-const particle iterator
@@ -536,7 +678,7 @@ namespace HepMC {
     /// Used to iterate over all particles in the event.
     class particle_iterator : public std::iterator<std::forward_iterator_tag,HepMC::GenParticle*,ptrdiff_t> {
     public:
-      particle_iterator( const std::map<int,HepMC::GenParticle*>::iterator& i ) : m_map_iterator( i ) {}
+      particle_iterator( const detail::BarcodeIndex<HepMC::GenParticle>::const_iterator& i ) : m_index_iterator( i ) {}
       particle_iterator() {}
       /// copy constructor
       particle_iterator( const particle_iterator& i ) { *this = i; }
@@ -544,25 +686,25 @@ namespace HepMC {
       virtual ~particle_iterator() {}
       /// make a copy
       particle_iterator&  operator=( const particle_iterator& i ) {
-        m_map_iterator = i.m_map_iterator;
+        m_index_iterator = i.m_index_iterator;
         return *this;
       }
       /// const particle iterator
-      operator particle_const_iterator() const { return particle_const_iterator(m_map_iterator); }
+      operator particle_const_iterator() const { return particle_const_iterator(m_index_iterator); }
       /// return pointer to GenParticle
-      GenParticle* operator*(void) const { return m_map_iterator->second; }
+      GenParticle* operator*(void) const { return *m_index_iterator; }
       /// Pre-fix increment
-      particle_iterator& operator++(void) { ++m_map_iterator; return *this; }
+      particle_iterator& operator++(void) { ++m_index_iterator; return *this; }
       /// Post-fix increment
       particle_iterator operator++(int) { particle_iterator out(*this); ++(*this); return out; }
       /// equality
-      bool operator==( const particle_iterator& a ) const { return m_map_iterator == a.m_map_iterator; }
+      bool operator==( const particle_iterator& a ) const { return m_index_iterator == a.m_index_iterator; }
       /// inequality
-      bool operator!=( const particle_iterator& a ) const { return !(m_map_iterator == a.m_map_iterator); }
+      bool operator!=( const particle_iterator& a ) const { return !(m_index_iterator == a.m_index_iterator); }
 
     protected:
-      /// iterator for GenParticle map
-      std::map<int,HepMC::GenParticle*>::iterator m_map_iterator;
+      /// iterator for the GenParticle index
+      detail::BarcodeIndex<HepMC::GenParticle>::const_iterator m_index_iterator;
 
     private:
       /// Pre-fix increment
@@ -573,9 +715,9 @@ namespace HepMC {
 
     friend class particle_iterator;
     /// begin particle iteration
-    particle_iterator particles_begin() { return GenEvent::particle_iterator(m_particle_barcodes.begin() ); }
+    particle_iterator particles_begin() { assign_barcodes(); return GenEvent::particle_iterator(m_particle_barcodes.begin() ); }
     /// end particle iteration
-    particle_iterator particles_end() { return GenEvent::particle_iterator(m_particle_barcodes.end() ); }
+    particle_iterator particles_end() { assign_barcodes(); return GenEvent::particle_iterator(m_particle_barcodes.end() ); }
 
 
   protected:
@@ -589,11 +731,51 @@ namespace HepMC {
     /// Set the barcode -- intended for use by GenVertex
     bool set_barcode( GenVertex*   v, int suggested_barcode =false );
     /// Remove the barcode -- intended for use by GenParticle
-    void remove_barcode( GenParticle* p ) { m_particle_barcodes.erase( p->barcode() ); }
+    void remove_barcode( GenParticle* p );
     /// Remove the barcode -- intended for use by GenVertex
-    void remove_barcode( GenVertex* v ) { m_vertex_barcodes.erase( v->barcode() ); }
+    void remove_barcode( GenVertex* v );
     /// Delete all vertices owned by this event
     void delete_all_vertices();
+    /// Like delete_all_vertices, but keep the objects for reuse
+    void recycle_all_vertices();
+    /// Delete the particles and vertices kept for reuse
+    void delete_recycled_objects();
+    /// Reset a detached particle and keep it for reuse
+    void recycle_particle_( GenParticle* p );
+    /// Copy the event information of inevent into this cleared event
+    void copy_header_( const GenEvent& inevent );
+    /// Copy the vertices and particles of inevent into this empty event
+    void copy_graph_( const GenEvent& inevent );
+
+    // Following methods build the event graph without any checks and
+    // without the barcode bookkeeping of add_vertex and add_particle_in/out.
+    // The caller guarantees that the barcodes are unique and that the
+    // vertices a particle is attached to belong to this event.
+    /// Enter a detached vertex in this event with the given barcode
+    void adopt_vertex_( GenVertex* v, int barcode );
+    /// Enter a detached particle in this event with the given barcode
+    void adopt_particle_( GenParticle* p, int barcode );
+    /// Append p to the incoming particles of v
+    static void attach_in_( GenVertex* v, GenParticle* p );
+    /// Append p to the outgoing particles of v
+    static void attach_out_( GenVertex* v, GenParticle* p );
+    /// Make room for nin incoming and nout outgoing particles of v
+    static void reserve_particles_( GenVertex* v, int nin, int nout );
+
+    /// Give the deferred barcodes, see defer_barcodes()
+    void assign_deferred_barcodes_() const;
+    /// Add an object to the lists of deferred barcodes, unless it is there
+    void defer_( GenParticle* p );
+    void defer_( GenVertex* v );
+    /// Replace old by obj, which may be null, in the lists of deferred
+    /// barcodes, in constant time; the lists are emptied when the last
+    /// waiting object is removed
+    void replace_deferred_( const GenParticle* old, GenParticle* obj );
+    void replace_deferred_( const GenVertex* old, GenVertex* obj );
+    /// Work out ordered_vertices() and the vertex depths
+    void order_vertices_() const;
+    /// The event graph has changed, see ordered_vertices()
+    void invalidate_vertex_order_() { m_vertex_order_valid = false; }
 
 
   private:
@@ -637,13 +819,31 @@ namespace HepMC {
     WeightContainer       m_weights; // weights for this event; first weight is used by default for hit and miss
     std::vector<long>     m_random_states; // container of rndm num generator states
 
-    std::map< int,HepMC::GenVertex*,std::greater<int> >   m_vertex_barcodes;
-    std::map< int,HepMC::GenParticle*,std::less<int> >    m_particle_barcodes;
+    // barcode indices: particles are keyed by barcode, vertices by -barcode,
+    // so that both iterate in order of increasing |barcode|.
+    // They are completed on first use when barcodes are deferred,
+    // by const functions too.
+    mutable detail::BarcodeIndex<HepMC::GenVertex>    m_vertex_barcodes;
+    mutable detail::BarcodeIndex<HepMC::GenParticle>  m_particle_barcodes;
+    bool                  m_defer_barcodes;
+    mutable std::vector<GenParticle*>  m_deferred_particles; // waiting for a barcode
+    mutable std::vector<GenVertex*>    m_deferred_vertices;
+    mutable int           m_deferred_particles_waiting; // non-null entries of the lists
+    mutable int           m_deferred_vertices_waiting;
     GenCrossSection*      m_cross_section;    // undefined by default
     HeavyIon*             m_heavy_ion;        // undefined by default
     PdfInfo*              m_pdf_info;         // undefined by default
     Units::MomentumUnit   m_momentum_unit;    // default value set by configure switch
     Units::LengthUnit     m_position_unit;    // default value set by configure switch
+    EventArena*           m_arena;            // created on first use
+    bool                  m_use_arena;
+    std::vector<GenParticle*>  m_free_particles; // kept by clear() for reuse
+    std::vector<GenVertex*>    m_free_vertices;
+    bool                  m_recycle;
+    mutable std::vector<GenVertex*>  m_vertex_order; // see ordered_vertices()
+    mutable bool          m_vertex_order_valid;
+    bool                  m_beam_1_in_event;  // see valid_beam_particles()
+    bool                  m_beam_2_in_event;
 
   };
 
@@ -701,9 +901,8 @@ namespace HepMC {
   /// the barcode data member and causes confusion among users.
   inline GenParticle* GenEvent::barcode_to_particle( int barCode ) const
   {
-    std::map<int,HepMC::GenParticle*>::const_iterator i
-      = m_particle_barcodes.find(barCode);
-    return ( i != m_particle_barcodes.end() ) ? (*i).second : 0;
+    assign_barcodes();
+    return m_particle_barcodes.find(barCode);
   }
 
   /// Each vertex or particle has a barcode, which is just an integer which
@@ -726,22 +925,23 @@ namespace HepMC {
   /// the barcode data member and causes confusion among users.
   inline GenVertex* GenEvent::barcode_to_vertex( int barCode ) const
   {
-    std::map<int,GenVertex*,std::greater<int> >::const_iterator i
-      = m_vertex_barcodes.find(barCode);
-    return ( i != m_vertex_barcodes.end() ) ? (*i).second : 0;
+    assign_barcodes();
+    return m_vertex_barcodes.find(-barCode);
   }
 
   inline int GenEvent::particles_size() const {
-    return (int)m_particle_barcodes.size();
+    assign_barcodes();
+    return m_particle_barcodes.size();
   }
   inline bool GenEvent::particles_empty() const {
-    return (bool)m_particle_barcodes.empty();
+    return m_particle_barcodes.empty() && m_deferred_particles_waiting == 0;
   }
   inline int GenEvent::vertices_size() const {
-    return (int)m_vertex_barcodes.size();
+    assign_barcodes();
+    return m_vertex_barcodes.size();
   }
   inline bool GenEvent::vertices_empty() const {
-    return (bool)m_vertex_barcodes.empty();
+    return m_vertex_barcodes.empty() && m_deferred_vertices_waiting == 0;
   }
 
   // beam particles
@@ -0,0 +1,98 @@
+#ifndef HEPMC_GEN_EVENT_COLUMNS_H
+#define HEPMC_GEN_EVENT_COLUMNS_H
+
+//////////////////////////////////////////////////////////////////////////
+// GenEventColumns.h
+//
+// Read-only structure-of-arrays snapshot of a GenEvent
+//////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+namespace HepMC {
+
+  class GenEvent;
+
+  //! GenEventColumns holds the particles and vertices of an event as arrays
+
+  ///
+  /// \class GenEventColumns
+  /// fill() copies the particle and vertex properties of a GenEvent into
+  /// one contiguous array per property, so that selections and sums over
+  /// all particles can be written as plain loops over arrays instead of
+  /// walking the event graph.
+  ///
+  /// Particle i is the i-th particle of GenEvent::particles_begin(),
+  /// vertex j the j-th vertex of GenEvent::vertices_begin().
+  /// Momenta and positions are in the units of the event.
+  /// production_vertex() and end_vertex() hold vertex indices,
+  /// or -1 if the particle has no such vertex in this event.
+  ///
+  /// The snapshot does not change when the event does.
+  /// It is meant to be refilled for every event: the arrays keep their
+  /// capacity, so refilling allocates only for an event larger than
+  /// all the ones before.
+  ///
+  class GenEventColumns {
+  public:
+    GenEventColumns() {}
+    /// snapshot of evt
+    explicit GenEventColumns( const GenEvent& evt ) { fill( evt ); }
+
+    /// replace the contents by a snapshot of evt
+    void fill( const GenEvent& evt );
+    /// remove all particles and vertices, keeping the capacity
+    void clear();
+
+    /// number of particles
+    int particles_size() const { return (int)m_barcode.size(); }
+    /// number of vertices
+    int vertices_size() const { return (int)m_vertex_barcode.size(); }
+
+    /// @name particle columns
+    //@{
+    const std::vector<double>& px() const { return m_px; }
+    const std::vector<double>& py() const { return m_py; }
+    const std::vector<double>& pz() const { return m_pz; }
+    const std::vector<double>& e() const { return m_e; }
+    const std::vector<double>& generated_mass() const { return m_generated_mass; }
+    const std::vector<int>& pdg_id() const { return m_pdg_id; }
+    const std::vector<int>& status() const { return m_status; }
+    const std::vector<int>& barcode() const { return m_barcode; }
+    /// index of the production vertex, or -1
+    const std::vector<int>& production_vertex() const { return m_production_vertex; }
+    /// index of the end vertex, or -1
+    const std::vector<int>& end_vertex() const { return m_end_vertex; }
+    //@}
+
+    /// @name vertex columns
+    //@{
+    const std::vector<double>& x() const { return m_x; }
+    const std::vector<double>& y() const { return m_y; }
+    const std::vector<double>& z() const { return m_z; }
+    const std::vector<double>& t() const { return m_t; }
+    const std::vector<int>& vertex_barcode() const { return m_vertex_barcode; }
+    //@}
+
+  private: // data members
+    std::vector<double>  m_px;
+    std::vector<double>  m_py;
+    std::vector<double>  m_pz;
+    std::vector<double>  m_e;
+    std::vector<double>  m_generated_mass;
+    std::vector<int>     m_pdg_id;
+    std::vector<int>     m_status;
+    std::vector<int>     m_barcode;
+    std::vector<int>     m_production_vertex;
+    std::vector<int>     m_end_vertex;
+
+    std::vector<double>  m_x;
+    std::vector<double>  m_y;
+    std::vector<double>  m_z;
+    std::vector<double>  m_t;
+    std::vector<int>     m_vertex_barcode;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_GEN_EVENT_COLUMNS_H
@@ -0,0 +1,173 @@
+#ifndef HEPMC_GEN_EVENT_COMPACT_H
+#define HEPMC_GEN_EVENT_COMPACT_H
+
+//////////////////////////////////////////////////////////////////////////
+// GenEventCompact.h
+//
+// Event stored in contiguous arrays, linked by index
+//////////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include <vector>
+
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  //! GenEventCompact holds a whole event in a few contiguous arrays
+
+  ///
+  /// \class GenEventCompact
+  /// Particles and vertices are kept in two arrays and refer to each other
+  /// by 32 bit index instead of by pointer. The incoming and outgoing
+  /// particles of all vertices are stored back to back in one array each,
+  /// with an offset per vertex (compressed sparse row), so that there is
+  /// no container per vertex.
+  /// Colour flow, polarization and vertex weights, which most particles
+  /// and vertices do not have, are kept in separate tables.
+  /// The result takes less than half the memory of the same GenEvent and
+  /// is read without following pointers across the heap.
+  ///
+  /// fill() converts a GenEvent, fill_event() converts back to a GenEvent
+  /// which writes out exactly like the original.
+  /// Particle i is the i-th particle of GenEvent::particles_begin(),
+  /// vertex j the j-th vertex of GenEvent::vertices_begin(),
+  /// and -1 stands for no particle or vertex, as in GenEventColumns.
+  ///
+  /// The contents do not change when the original event does.
+  ///
+  class GenEventCompact {
+  public:
+    /// a contiguous range of particle indices
+    class IndexRange {
+    public:
+      IndexRange( const int* b = 0, const int* e = 0 ) : m_begin(b), m_end(e) {}
+      const int* begin() const { return m_begin; }
+      const int* end() const { return m_end; }
+      int size() const { return (int)( m_end - m_begin ); }
+      bool empty() const { return m_begin == m_end; }
+      int operator[]( int k ) const { return m_begin[k]; }
+    private:
+      const int* m_begin;
+      const int* m_end;
+    };
+
+    GenEventCompact();
+    /// compact copy of evt
+    explicit GenEventCompact( const GenEvent& evt );
+
+    /// replace the contents by a compact copy of evt
+    void fill( const GenEvent& evt );
+    /// replace the contents of evt by this event
+    void fill_event( GenEvent* evt ) const;
+    /// remove all particles and vertices, keeping the capacity
+    void clear();
+
+    /// the event information, without particles and vertices
+    const GenEvent& header() const { return m_header; }
+
+    /// number of particles
+    int particles_size() const { return (int)m_particles.size(); }
+    /// number of vertices
+    int vertices_size() const { return (int)m_vertices.size(); }
+
+    /// @name particle properties
+    //@{
+    const FourVector& momentum( int i ) const { return m_particles[i].momentum; }
+    double generated_mass( int i ) const { return m_particles[i].generated_mass; }
+    int pdg_id( int i ) const { return m_particles[i].pdg_id; }
+    int status( int i ) const { return m_particles[i].status; }
+    int barcode( int i ) const { return m_particles[i].barcode; }
+    /// index of the production vertex, or -1
+    int production_vertex( int i ) const { return m_particles[i].production_vertex; }
+    /// index of the end vertex, or -1
+    int end_vertex( int i ) const { return m_particles[i].end_vertex; }
+    /// flow code, as GenParticle::flow( code_index )
+    int flow( int i, int code_index ) const;
+    /// polarization, (0,0) if none was set
+    Polarization polarization( int i ) const;
+    //@}
+
+    /// @name vertex properties
+    //@{
+    const FourVector& position( int j ) const { return m_vertices[j].position; }
+    int vertex_status( int j ) const { return m_vertices[j].status; }
+    int vertex_barcode( int j ) const { return m_vertices[j].barcode; }
+    /// vertex weights, empty if none were set
+    const WeightContainer& vertex_weights( int j ) const;
+    /// incoming particles of vertex j
+    IndexRange particles_in( int j ) const
+    { return IndexRange( in_data() + m_in_offsets[j], in_data() + m_in_offsets[j+1] ); }
+    /// outgoing particles of vertex j
+    IndexRange particles_out( int j ) const
+    { return IndexRange( out_data() + m_out_offsets[j], out_data() + m_out_offsets[j+1] ); }
+    //@}
+
+    /// index of the signal process vertex, or -1
+    int signal_process_vertex() const { return m_signal_process_vertex; }
+    /// indices of the beam particles, or -1
+    std::pair<int,int> beam_particles() const { return m_beam_particles; }
+
+    /// @name navigation
+    //@{
+    /// the incoming particles of the production vertex of particle i
+    IndexRange parents( int i ) const;
+    /// the outgoing particles of the end vertex of particle i
+    IndexRange children( int i ) const;
+    /// replace the contents of out by all particles particle i comes from
+    void ancestors( int i, std::vector<int>& out ) const;
+    /// replace the contents of out by all particles coming from particle i
+    void descendants( int i, std::vector<int>& out ) const;
+    //@}
+
+  private:
+    struct Particle {
+      FourVector momentum;
+      double     generated_mass;
+      int        pdg_id;
+      int        status;
+      int        barcode;
+      int        production_vertex;
+      int        end_vertex;
+    };
+    struct Vertex {
+      FourVector position;
+      int        status;
+      int        barcode;
+    };
+    struct FlowCode {
+      int particle;
+      int code_index;
+      int code;
+    };
+    typedef std::pair<int,Polarization>    PolarizationEntry;
+    typedef std::pair<int,WeightContainer> WeightsEntry;
+
+    const int* in_data() const { return m_in.empty() ? 0 : &m_in[0]; }
+    const int* out_data() const { return m_out.empty() ? 0 : &m_out[0]; }
+    /// index of the particle with this barcode
+    int particle_index( int barcode ) const;
+    /// index of the vertex with this barcode
+    int vertex_index( int barcode ) const;
+    /// all particles reached from vertex j, walking against
+    /// (or along) the direction of the particles
+    void walk( int j, bool backwards, std::vector<int>& out ) const;
+
+  private: // data members
+    GenEvent                        m_header;
+    std::vector<Particle>           m_particles;
+    std::vector<Vertex>             m_vertices;
+    std::vector<int>                m_in_offsets;   // vertex j: m_in[m_in_offsets[j]] ...
+    std::vector<int>                m_in;
+    std::vector<int>                m_out_offsets;
+    std::vector<int>                m_out;
+    std::vector<FlowCode>           m_flow;         // sorted by particle
+    std::vector<PolarizationEntry>  m_polarization; // sorted by particle
+    std::vector<WeightsEntry>       m_vertex_weights; // sorted by vertex
+    int                             m_signal_process_vertex;
+    std::pair<int,int>              m_beam_particles;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_GEN_EVENT_COMPACT_H
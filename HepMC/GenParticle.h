@@ -29,6 +29,9 @@
 #include "HepMC/SimpleVector.h"
 #include "HepMC/IteratorRange.h"
 #include <iostream>
+#include <cstddef>
+#include <utility>
+#include <vector>
 
 /// @todo Why? And why here?
 #ifdef _WIN32
@@ -42,12 +45,41 @@ namespace HepMC {
 
   class GenVertex;
   class GenEvent;
+  class EventArena;
 
   struct GenParticleProductionRange;
   struct ConstGenParticleProductionRange;
   struct GenParticleEndRange;
   struct ConstGenParticleEndRange;
 
+  class GenParticle;
+
+  /// @brief A list of particles held by a vertex, read in place
+  ///
+  /// GenParticleVectorRange points into the particles of a vertex, so it is
+  /// made without copying them. It stays valid as long as the particles of
+  /// the vertex do not change.
+  /// It acts like a collection of particles, for use with Boost foreach
+  /// and C++11 range-for.
+  class GenParticleVectorRange {
+  public:
+    typedef GenParticle* const* iterator;
+    typedef GenParticle* const* const_iterator;
+    /// an empty list
+    GenParticleVectorRange() : m_begin(0), m_end(0) {}
+    /// the particles of v, which must outlive the range
+    explicit GenParticleVectorRange( const std::vector<GenParticle*>& v )
+      : m_begin( v.empty() ? 0 : &v[0] ), m_end( m_begin + v.size() ) {}
+    iterator begin() const { return m_begin; }
+    iterator end() const { return m_end; }
+    int size() const { return (int)( m_end - m_begin ); }
+    bool empty() const { return m_begin == m_end; }
+    GenParticle* operator[]( int i ) const { return m_begin[i]; }
+  private:
+    iterator m_begin;
+    iterator m_end;
+  };
+
 
   /// @brief The GenParticle class contains information about generated particles
   ///
@@ -80,6 +112,40 @@ namespace HepMC {
     void swap( GenParticle& other); //!< swap
     GenParticle& operator=( const GenParticle& inparticle ); //!< shallow.
 
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+    /// move: this particle takes the place of inparticle in its vertices
+    /// and event, and takes over its barcode.
+    /// inparticle is left detached.
+    GenParticle( GenParticle&& inparticle )
+      : m_momentum( inparticle.m_momentum ),
+        m_pdg_id( inparticle.m_pdg_id ),
+        m_status( inparticle.m_status ),
+        m_flow( this ),
+        m_polarization( inparticle.m_polarization ),
+        m_production_vertex( 0 ),
+        m_end_vertex( 0 ),
+        m_barcode( 0 ),
+        m_deferred_slot( -1 ),
+        m_in_arena( 0 ),
+        m_generated_mass( inparticle.m_generated_mass )
+    {
+      inparticle.m_polarization = 0;
+      m_flow = std::move( inparticle.m_flow );
+      take_place_of_( inparticle );
+    }
+    /// move the properties only, neither particle changes its place
+    /// in the event
+    GenParticle& operator=( GenParticle&& inparticle ) {
+      m_momentum = inparticle.m_momentum;
+      m_pdg_id = inparticle.m_pdg_id;
+      m_status = inparticle.m_status;
+      m_flow = std::move( inparticle.m_flow );
+      std::swap( m_polarization, inparticle.m_polarization );
+      m_generated_mass = inparticle.m_generated_mass;
+      return *this;
+    }
+#endif
+
     /// check for equality
     bool operator == ( const GenParticle& ) const;
     /// check for inequality
@@ -88,6 +154,16 @@ namespace HepMC {
     /// dump this particle's full info to ostr
     void print( std::ostream& ostr = std::cout ) const;
 
+    /// @name Allocation
+    /// A particle lives either on the heap or in the arena of an event
+    /// (see GenEvent::use_arena); in both cases it is released with delete.
+    //@{
+    static void* operator new( std::size_t );
+    static void* operator new( std::size_t, void* place ) { return place; }
+    static void operator delete( void*, std::size_t );
+    static void operator delete( void*, void* ) {}
+    //@}
+
     /// Conversion operator to 4-vector
     operator HepMC::FourVector() const { return m_momentum; }
 
@@ -120,8 +196,8 @@ namespace HepMC {
 
     /// Polarization information
     /// @deprecated Polarization will be removed in HepMC3 -- stop using it!
-    /// @todo Should be handled as a pointer, since optional... but too late now
-    const Polarization& polarization() const { return m_polarization; }
+    /// (0,0) unless set_polarization() was called
+    const Polarization& polarization() const;
 
     /// Pointer to the production vertex
     GenVertex* production_vertex() { return m_production_vertex; }
@@ -138,19 +214,26 @@ namespace HepMC {
 
 
     /// @brief Immediate incoming particles via production vertex
-    /// @note Less efficient than going via the production vertex since if there is no vertex we must return an empty vector -- by value.
+    /// @note Less efficient than going via the production vertex since if there is no vertex we must return an empty vector -- by value. parent_range() does not copy.
     std::vector<GenParticle*> parents();
     /// @brief Immediate incoming particles via production vertex (const)
-    /// @note Less efficient than going via the production vertex since if there is no vertex we must return an empty vector -- by value.
+    /// @note Less efficient than going via the production vertex since if there is no vertex we must return an empty vector -- by value. parent_range() does not copy.
     const std::vector<GenParticle*> parents() const;
 
     /// @brief Immediate outgoing particles via end vertex
-    /// @note Less efficient than going via the end vertex since if there is no vertex we must return an empty vector -- by value.
+    /// @note Less efficient than going via the end vertex since if there is no vertex we must return an empty vector -- by value. child_range() does not copy.
     std::vector<GenParticle*> children();
     /// @brief Immediate outgoing particles via end vertex (const)
-    /// @note Less efficient than going via the end vertex since if there is no vertex we must return an empty vector -- by value.
+    /// @note Less efficient than going via the end vertex since if there is no vertex we must return an empty vector -- by value. child_range() does not copy.
     const std::vector<GenParticle*> children() const;
 
+    /// @brief Immediate incoming particles via production vertex, without a copy
+    /// @note Empty if there is no production vertex
+    GenParticleVectorRange parent_range() const;
+    /// @brief Immediate outgoing particles via end vertex, without a copy
+    /// @note Empty if there is no end vertex
+    GenParticleVectorRange child_range() const;
+
     /// @brief All incoming particles via production vertex
     GenParticleProductionRange ancestors();
     /// @brief All incoming particles via production vertex (const)
@@ -189,10 +272,13 @@ namespace HepMC {
     /// encode extra information is not recommended and cannot be guaranteed to work.
     ///
     /// @note Barcodes are replaced with ID codes in HepMC3.
-    int barcode() const { return m_barcode; }
+    int barcode() const {
+      if ( m_barcode == 0 ) assign_deferred_barcode_();
+      return m_barcode;
+    }
     /// Alias for barcode which will keep working in HepMC3
     /// @note The ID is not quite the same as barcode in HepMC3: it is just an automatic identifier, with no semantic meaning
-    int id() const { return m_barcode; }
+    int id() const { return barcode(); }
 
 
     /// Check if the particle is undecayed. Returns true if status==1
@@ -268,10 +354,7 @@ namespace HepMC {
     }
 
     /// Set the polarization object
-    /// @todo -> ptr
-    void set_polarization( const Polarization& pol = Polarization(0,0) ) {
-      m_polarization = pol;
-    }
+    void set_polarization( const Polarization& pol = Polarization(0,0) );
 
     /// @brief Set the generated mass
     ///
@@ -294,20 +377,31 @@ namespace HepMC {
     void set_end_vertex_( GenVertex* decayvertex = 0 );
     //!< for use by GenEvent only
     void set_barcode_( int bc ) { m_barcode = bc; }
+    /// a particle without barcode may be waiting for one from its event,
+    /// see GenEvent::defer_barcodes()
+    void assign_deferred_barcode_() const;
+    /// for use by the move constructor
+    void take_place_of_( GenParticle& other );
 
     /// scale the momentum vector and generated mass
     /// this method is only for use by GenEvent
     void convert_momentum( const double& );
 
   private:
+    /// only GenEvent allocates from its arena, and marks the particle
+    static void* operator new( std::size_t, EventArena& );
+    static void operator delete( void*, EventArena& );
+
     FourVector       m_momentum;          //< Momentum vector
     int              m_pdg_id;            //< Particle ID code according to the PDG scheme
     int              m_status;            //< Particle status
     Flow             m_flow;              //< Colour flow object
-    Polarization     m_polarization;      //< Polarization object
+    Polarization*    m_polarization;      //< Polarization object, null if (0,0)
     GenVertex*       m_production_vertex; //< Null if vacuum or beam
     GenVertex*       m_end_vertex;        //< Null if not-decayed
     int              m_barcode;           //< Unique identifier in the event
+    int              m_deferred_slot : 31;//< Place in the list of the event while the barcode is deferred
+    unsigned         m_in_arena : 1;      //< Set by GenEvent, read by operator delete
     double           m_generated_mass;    //< Mass of this particle as set by the generator
 
   };
@@ -29,6 +29,7 @@
 #include <set>
 #include <algorithm>
 #include <cstddef>
+#include <utility>
 
 namespace HepMC {
 
@@ -40,6 +41,7 @@ namespace HepMC {
 
   class GenParticle;
   class GenEvent;
+  class EventArena;
 
 
   //! GenVertex contains information about decay vertices.
@@ -70,11 +72,47 @@ namespace HepMC {
 
     void swap( GenVertex & other); //!< swap
     GenVertex& operator= ( const GenVertex& invertex ); //!< shallow
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+    /// move: this vertex takes over the particles of invertex and its place
+    /// in the event, including its barcode.
+    /// invertex is left empty and detached.
+    GenVertex( GenVertex&& invertex )
+      : m_position( invertex.m_position ),
+        m_particles_in( std::move( invertex.m_particles_in ) ),
+        m_particles_out( std::move( invertex.m_particles_out ) ),
+        m_status( invertex.m_status ),
+        m_weights( std::move( invertex.m_weights ) ),
+        m_event( 0 ),
+        m_barcode( 0 ),
+        m_depth( -1 ),
+        m_deferred_slot( -1 ),
+        m_in_arena( false )
+    { take_place_of_( invertex ); }
+    /// move the position, status and weights only, neither vertex
+    /// changes its particles or its place in the event
+    GenVertex& operator= ( GenVertex&& invertex ) {
+      m_position = invertex.m_position;
+      m_status = invertex.m_status;
+      m_weights = std::move( invertex.m_weights );
+      return *this;
+    }
+#endif
     bool operator==( const GenVertex& a ) const; //!< equality
     bool operator!=( const GenVertex& a ) const; //!< inequality
     void print( std::ostream& ostr = std::cout ) const; //!< print vertex information
 
+    /// @name Allocation
+    /// A vertex lives either on the heap or in the arena of an event
+    /// (see GenEvent::use_arena); in both cases it is released with delete.
+    //@{
+    static void* operator new( std::size_t );
+    static void* operator new( std::size_t, void* place ) { return place; }
+    static void operator delete( void*, std::size_t );
+    static void operator delete( void*, void* ) {}
+    //@}
+
     /// @todo Remove
+    /// @note MomentumBalance checks the four-momentum of all vertices of an event at once
     double check_momentum_conservation() const;//!< |Sum (three_mom_in-three_mom_out)|
 
     /// add incoming particle
@@ -129,11 +167,22 @@ namespace HepMC {
     /// HepMC as a unique identifier for the particles and vertices.
     /// Using the barcode to encode extra information is an abuse of
     /// the barcode data member and causes confusion among users.
-    int barcode() const { return m_barcode; }
+    int barcode() const {
+      if ( m_barcode == 0 ) assign_deferred_barcode_();
+      return m_barcode;
+    }
 
     /// Try to manually set the barcode: discouraged but widespread
     bool suggest_barcode( int the_bar_code );
 
+    /// @brief Generation of this vertex in its event
+    ///
+    /// 0 if none of the incoming particles comes from a vertex of the
+    /// same event, otherwise one more than the largest depth of those
+    /// vertices. -1 if the vertex is not in an event or lies on a loop.
+    /// See GenEvent::ordered_vertices().
+    int depth() const;
+
     /// Direct access to the weights container is allowed.
     WeightContainer& weights() { return m_weights; }
     /// Const direct access to the weights container
@@ -218,7 +267,11 @@ namespace HepMC {
     ///  vertex to an event
     void set_parent_event_( GenEvent* evt ); //!< set parent event
     void set_barcode_( int bc ) { m_barcode = bc; } //!< set identifier
+    /// a vertex without barcode may be waiting for one from its event,
+    /// see GenEvent::defer_barcodes()
+    void assign_deferred_barcode_() const;
     void change_parent_event_( GenEvent* evt ); //!< for use with swap
+    void take_place_of_( GenVertex& other ); //!< for use by the move constructor
 
     /////////////////////////////
     // edge_iterator           // (protected - for internal use only)
@@ -304,6 +357,21 @@ namespace HepMC {
     /// (by "chopping" the edges connecting to an already visited
     /// vertex) and returning the vertices in POST ORDER traversal.
     ///
+    /// The traversal keeps the path from the root to the current vertex
+    /// on a stack, and the visited vertices in an open addressing hash
+    /// table of its own, so that it does not allocate for every vertex
+    /// and every edge, and does not write to the vertices or the event:
+    /// any number of threads may traverse the same event at once.
+    ///
+    /// The price is paid per iterator rather than per vertex: a new
+    /// iterator allocates its stack and a table of 16 entries, which
+    /// doubles as needed, and a copy (e.g. the post-fix increment)
+    /// duplicates both.  start() and assignment reuse the buffers they
+    /// already have, so an iterator which is restarted, like the one in
+    /// particle_iterator, allocates only while its buffers grow.
+    /// Probing the table makes a long traversal about 30% slower than
+    /// marking the vertices themselves would.
+    ///
     class vertex_iterator : public std::iterator<std::forward_iterator_tag,HepMC::GenVertex*,ptrdiff_t>{
     public:
       vertex_iterator();
@@ -316,6 +384,21 @@ namespace HepMC {
       virtual ~vertex_iterator();
       /// make a copy
       vertex_iterator& operator=( const vertex_iterator& );
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+      /// move: takes over the traversal of v_iter
+      vertex_iterator( vertex_iterator&& v_iter ) noexcept
+        : m_vertex(0), m_range(), m_stack(), m_visited(), m_visited_count(0),
+          m_visited_vertices(0)
+      { swap( v_iter ); }
+      /// move: takes over the traversal of v_iter
+      vertex_iterator& operator=( vertex_iterator&& v_iter ) noexcept {
+        vertex_iterator tmp( std::move( v_iter ) );
+        swap( tmp );
+        return *this;
+      }
+#endif
+      /// swap
+      void swap( vertex_iterator& other );
       /// return a pointer to a vertex
       GenVertex* operator*(void) const;
       /// Pre-fix increment
@@ -332,28 +415,38 @@ namespace HepMC {
       IteratorRange range() const { return m_range; }
       /// intended for internal use only.
       void copy_with_own_set( const vertex_iterator& v_iter, std::set<const HepMC::GenVertex*>& visited_vertices );
+      /// intended for internal use only: begin a new iteration,
+      /// like the constructor
+      void start( GenVertex& vtx_root, IteratorRange range );
 
-    protected:
-      // intended for internal use only
-      /// non-null if recursive iter. created
-      GenVertex* follow_edge_();
-      /// copy recursive iterator
-      void copy_recursive_iterator_( const vertex_iterator*
-                                        recursive_v_iter );
     private:
       /// Pre-fix increment -- is not allowed
       vertex_iterator& operator--(void);
       /// Post-fix increment -- is not allowed
       vertex_iterator operator--(int);
 
+      /// a vertex on the path from the root, with the edge to follow next
+      struct Frame {
+        GenVertex*    vertex;
+        edge_iterator edge;
+      };
+      /// descend from the top of the stack to the next vertex to return
+      void advance_();
+      /// add vtx to the visited vertices, false if it was there already
+      bool visit_( const GenVertex* vtx );
+      /// double the size of the hash table of the visited vertices
+      void grow_visited_();
+
     private:
-      GenVertex* m_vertex;   // the vertex associated to this iter
+      GenVertex* m_vertex;   // the root of the iteration, null past the end
       IteratorRange m_range;
+      std::vector<Frame> m_stack;              // path from the root to the current vertex
+      std::vector<const GenVertex*> m_visited; // hash table of the visited vertices
+      std::size_t m_visited_count;             // number of vertices in m_visited
+      // set of the visited vertices shared with the iterator which made
+      // this one (see copy_with_own_set), used instead of m_visited;
+      // it is never owned
       std::set<const HepMC::GenVertex*>* m_visited_vertices;
-      bool m_it_owns_set;  // true if it is responsible for
-      // deleting the visited vertex set
-      edge_iterator m_edge; // particle edge pointing to return vtx
-      vertex_iterator* m_recursive_iterator;
     };
     friend class vertex_iterator;
     /// begin vertex range
@@ -392,6 +485,17 @@ namespace HepMC {
       particle_iterator&  operator++(void);
       /// Post-fix increment
       particle_iterator operator++(int);
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+      /// move: takes over the traversal of p_iter
+      particle_iterator( particle_iterator&& p_iter ) noexcept
+        : m_vertex_iterator( std::move( p_iter.m_vertex_iterator ) ), m_edge( p_iter.m_edge ) {}
+      /// move: takes over the traversal of p_iter
+      particle_iterator& operator=( particle_iterator&& p_iter ) noexcept {
+        m_vertex_iterator = std::move( p_iter.m_vertex_iterator );
+        m_edge = p_iter.m_edge;
+        return *this;
+      }
+#endif
       /// equality
       bool operator==( const particle_iterator& a ) const { return **this == *a; }
       /// inequality
@@ -425,6 +529,10 @@ namespace HepMC {
 
 
   private:
+    /// only GenEvent allocates from its arena, and marks the vertex
+    static void* operator new( std::size_t, EventArena& );
+    static void operator delete( void*, EventArena& );
+
 
     FourVector              m_position;      //< 4-vec of vertex
     std::vector<HepMC::GenParticle*>  m_particles_in;  //< All incoming particles
@@ -434,6 +542,9 @@ namespace HepMC {
     WeightContainer m_weights;
     GenEvent* m_event;
     int m_barcode;
+    int m_depth;                // set by GenEvent::ordered_vertices
+    int m_deferred_slot;        // place in the list of the event while the barcode is deferred
+    bool m_in_arena;            // set by GenEvent, read by operator delete
 
   };
 
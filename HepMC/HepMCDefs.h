@@ -80,6 +80,18 @@
 #define HEPMC_HEAVY_ION_HAS_CENTRALITY 1
 #endif
 
+// particles and vertices can be allocated from an arena owned by the GenEvent
+#ifndef HEPMC_HAS_EVENT_ARENA
+#define HEPMC_HAS_EVENT_ARENA 1
+#endif
+
+// C++11 move constructors and move assignment are available
+#if __cplusplus >= 201103L
+#ifndef HEPMC_HAS_MOVE_SEMANTICS
+#define HEPMC_HAS_MOVE_SEMANTICS 1
+#endif
+#endif
+
 // define the version of HepMC.
 #ifndef HEPMC_VERSION
 #define HEPMC_VERSION "2.07.00"
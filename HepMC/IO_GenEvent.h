@@ -10,15 +10,19 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <fstream>
+#include <istream>
 #include <string>
 #include <map>
 #include <vector>
 #include "HepMC/IO_BaseClass.h"
 #include "HepMC/IO_Exception.h"
+#include "HepMC/MappedFileBuffer.h"
+#include "HepMC/StreamInfo.h"
 #include "HepMC/Units.h"
 
 namespace HepMC {
 
+  class EventIndex;
   class GenEvent;
   class GenVertex;
   class GenParticle;
@@ -59,11 +63,22 @@ namespace HepMC {
   /// Comments may appear anywhere in the file -- so long as they do not contain
   ///  any of the start/stop keys.
   ///
+  /// An input file can be memory mapped (see MappedFileBuffer) by giving
+  ///  map_input=true. The events are then read from the mapping without
+  ///  going through a file buffer. Input which cannot be mapped, such as a
+  ///  pipe, is read through a std::fstream with a large buffer.
+  ///
+  /// With an EventIndex of the input, seek_to_event() goes to any event
+  ///  without reading those before it. The index can be built by scanning
+  ///  the file, or recorded while the file is written (record_index).
+  ///
   class IO_GenEvent : public IO_BaseClass {
   public:
-    /// constructor requiring a file name and std::ios mode
+    /// constructor requiring a file name and std::ios mode,
+    /// and whether to memory map an input file
     IO_GenEvent( const std::string& filename="IO_GenEvent.dat",
-                 std::ios::openmode mode=std::ios::out );
+                 std::ios::openmode mode=std::ios::out,
+                 bool map_input=false );
     /// constructor requiring an input stream
     IO_GenEvent( std::istream & );
     /// constructor requiring an output stream
@@ -74,6 +89,19 @@ namespace HepMC {
     void          write_event( const GenEvent* evt );
     /// get the next event
     bool          fill_next_event( GenEvent* evt );
+    /// continue reading with the event whose "E" line starts at offset in
+    /// the input, in a listing of type io_type (see known_io) which has
+    /// a start key or not; false if there is no event there
+    bool          seek_to_offset( std::streamoff offset, int io_type = gen,
+                                  bool has_key = true );
+    /// continue reading with the n-th event of the input, counted from 0,
+    /// as given by index; false if there is no such event
+    bool          seek_to_event( const EventIndex& index, std::size_t n );
+    /// add every event which is written from now on to index,
+    /// or stop adding them if index is 0; the index must outlive the
+    /// writing, and the offsets are those of the output stream (tellp)
+    void          record_index( EventIndex* index ) { m_index = index; }
+
     /// insert a comment directly into the output file --- normally you
     ///  only want to do this at the beginning or end of the file. All
     ///  comments are preceded with "HepMC::IO_GenEvent-COMMENT\n"
@@ -104,18 +132,22 @@ namespace HepMC {
 
   private: // use of copy constructor is not allowed
 
-    IO_GenEvent( const IO_GenEvent& ) : IO_BaseClass() {}
+    IO_GenEvent( const IO_GenEvent& ) : IO_BaseClass(), m_mapped_stream(0), m_index(0) {}
 
   private: // data members
 
     std::ios::openmode  m_mode;
     std::fstream        m_file;
+    MappedFileBuffer    m_mapped;        // used instead of m_file if mapped
+    std::istream        m_mapped_stream; // on m_mapped
+    std::vector<char>   m_file_buffer;   // for m_file if it cannot be mapped
     std::ostream *      m_ostr;
     std::istream *      m_istr;
     std::ios *          m_iostr;
     bool                m_have_file;
     IO_Exception::ErrorType m_error_type;
     std::string         m_error_message;
+    EventIndex *        m_index;         // of the events written, if any
 
   };
 
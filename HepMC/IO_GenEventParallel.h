@@ -0,0 +1,88 @@
+#ifndef HEPMC_IO_GENEVENT_PARALLEL_H
+#define HEPMC_IO_GENEVENT_PARALLEL_H
+
+//////////////////////////////////////////////////////////////////////////
+// IO_GenEventParallel.h
+//
+// input of IO_GenEvent files, with the events parsed on several threads
+//////////////////////////////////////////////////////////////////////////
+
+#include <istream>
+#include <string>
+#include "HepMC/IO_BaseClass.h"
+#include "HepMC/IO_Exception.h"
+#include "HepMC/Units.h"
+
+namespace HepMC {
+
+  class GenEvent;
+  namespace detail { class ParallelReader; }
+
+  //! IO_GenEventParallel reads what IO_GenEvent writes, on several threads
+
+  ///
+  /// \class  IO_GenEventParallel
+  /// fill_next_event() returns the events of the input in the order of
+  /// the input, as IO_GenEvent does, but the events are parsed ahead on
+  /// other threads:
+  ///  - one thread splits the input into chunks of whole events, at the
+  ///    "E" lines and at the start and end keys of the event listings,
+  ///  - nthreads threads build the events of the chunks, each chunk
+  ///    through a stream of its own,
+  ///  - fill_next_event() takes the events of the chunks in turn.
+  /// At most a few chunks per thread are waiting to be taken, so that
+  /// the memory does not grow when the events are used slowly.
+  /// The threads are started by the first fill_next_event(), and stopped
+  /// at the end of the input or by the destructor.
+  ///
+  /// Input files are memory mapped when they can be (see MappedFileBuffer).
+  /// An input stream given to the constructor must not be used by anything
+  /// else while the events are read.
+  /// Files written by IO_Ascii and IO_ExtendedAscii can also be read;
+  /// particle data listings are skipped.
+  ///
+  /// With nthreads=0, or without POSIX threads (on Windows), the chunks
+  /// are parsed by the thread which calls fill_next_event().
+  ///
+  class IO_GenEventParallel : public IO_BaseClass {
+  public:
+    /// read the file filename on nthreads threads
+    IO_GenEventParallel( const std::string& filename, int nthreads );
+    /// read istr on nthreads threads
+    IO_GenEventParallel( std::istream& istr, int nthreads );
+    virtual       ~IO_GenEventParallel();
+
+    /// get the next event, which is swapped into evt (see GenEvent::swap)
+    bool          fill_next_event( GenEvent* evt );
+    /// not possible, events can only be read
+    void          write_event( const GenEvent* evt );
+
+    /// write to ostr
+    void          print( std::ostream& ostr = std::cout ) const;
+
+    /// units of files without units, see IO_GenEvent::use_input_units;
+    /// only before the first event is read
+    void use_input_units( Units::MomentumUnit, Units::LengthUnit );
+
+    /// number of threads which parse the events
+    int           threads() const { return m_nthreads; }
+
+    /// integer (enum) associated with read error
+    int           error_type()    const { return m_error_type; }
+    /// the read error message string
+    const std::string & error_message() const { return m_error_message; }
+
+  private: // copying is not allowed
+    IO_GenEventParallel( const IO_GenEventParallel& );
+    IO_GenEventParallel& operator=( const IO_GenEventParallel& );
+
+  private: // data members
+    detail::ParallelReader* m_reader;  // the input, chunks and threads
+    int                 m_nthreads;
+    IO_Exception::ErrorType m_error_type;
+    std::string         m_error_message;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_IO_GENEVENT_PARALLEL_H
@@ -84,8 +84,8 @@ namespace HepMC {
     void              set_trust_beam_particles( bool b = true );
 
   protected: // for internal use only
-    /// create a GenParticle
-    GenParticle* build_particle( int index );
+    /// create a GenParticle, allocated through evt if given
+    GenParticle* build_particle( int index, GenEvent* evt = 0 );
     /// create a production vertex
     void build_production_vertex(
                                  int i,std::vector<HepMC::GenParticle*>& hepevt_particle, GenEvent* evt );
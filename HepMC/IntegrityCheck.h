@@ -0,0 +1,122 @@
+#ifndef HEPMC_INTEGRITY_CHECK_H
+#define HEPMC_INTEGRITY_CHECK_H
+
+//////////////////////////////////////////////////////////////////////////
+// IntegrityCheck.h
+//
+// Consistency of the particles, vertices and indices of an event
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+namespace HepMC {
+
+  class GenEvent;
+
+  //! IntegrityCheck finds the inconsistencies of an event in one pass
+
+  ///
+  /// \class IntegrityCheck
+  /// check() looks at every vertex and particle of an event once and
+  /// collects what is wrong with them: pointers between particles and
+  /// vertices which do not agree, particles and vertices which the barcode
+  /// indices of the event do not find, particles listed by several
+  /// vertices, vertices owned by another event, loops, and beam particles
+  /// or a signal process vertex which are not part of the event.
+  /// GenEvent::is_valid() only tells whether the event is empty.
+  ///
+  /// Pointers are only followed after they have been found among the
+  /// particles and vertices of the event, so that a pointer to a deleted
+  /// object is reported rather than used. The check takes time linear in
+  /// the size of the event and is cheap enough to be made for every event.
+  /// The object is meant to be reused and keeps its capacity.
+  ///
+  class IntegrityCheck {
+  public:
+    /// what can be wrong with an event
+    enum Problem {
+      foreign_vertex,               //!< vertex of the event belongs to another event
+      vertex_barcode,               //!< barcode_to_vertex does not find the vertex
+      particle_barcode,             //!< barcode_to_particle does not find the particle
+      particle_without_vertex,      //!< particle of the event has no vertex at all
+      dangling_production_vertex,   //!< production vertex is not in the event
+      dangling_end_vertex,          //!< end vertex is not in the event
+      dangling_particle,            //!< vertex lists a particle which is not in the event
+      wrong_production_vertex,      //!< vertex lists an outgoing particle made elsewhere
+      wrong_end_vertex,             //!< vertex lists an incoming particle ending elsewhere
+      missing_from_production_vertex, //!< production vertex does not list the particle
+      missing_from_end_vertex,      //!< end vertex does not list the particle
+      duplicate_particle,           //!< particle listed more than once by its vertex
+      loop,                         //!< vertex on a loop, or after one
+      beam_particle_not_in_event,   //!< beam particle is not in the event
+      signal_vertex_not_in_event    //!< signal process vertex is not in the event
+    };
+
+    /// one inconsistency
+    struct Issue {
+      Problem problem;
+      int     barcode;  // of the vertex or particle where it is found,
+                        // 0 for beam particles and signal process vertex
+    };
+
+    IntegrityCheck();
+    /// check evt
+    explicit IntegrityCheck( const GenEvent& evt );
+
+    /// replace the contents by the inconsistencies of evt,
+    /// and return true if there are none
+    bool check( const GenEvent& evt );
+    /// forget the event, keeping the capacity
+    void clear();
+
+    /// true if no inconsistencies were found
+    bool ok() const { return m_issues.empty(); }
+    /// the inconsistencies, in the order in which they were found
+    const std::vector<Issue>& issues() const { return m_issues; }
+    /// number of inconsistencies of one kind
+    int count( Problem problem ) const;
+
+    /// one line for every inconsistency
+    void print( std::ostream& ostr = std::cout ) const;
+    /// name of a problem, as printed
+    static const char* name( Problem problem );
+
+  private:
+    /// set of addresses with their position, by open addressing
+    class AddressTable {
+    public:
+      AddressTable() : m_address(), m_position(), m_mask(0) {}
+      /// empty table with room for n addresses
+      void reset( std::size_t n );
+      /// add address a at position i, false if it is there already
+      bool insert( const void* a, int i );
+      /// position of address a, or -1
+      int find( const void* a ) const;
+    private:
+      std::size_t slot( const void* a ) const;
+      std::vector<const void*> m_address;
+      std::vector<int>         m_position;
+      std::size_t              m_mask;
+    };
+
+    void add_( Problem problem, int barcode );
+
+  private: // data members
+    std::vector<Issue>  m_issues;
+    AddressTable        m_vertices;       // of the event
+    AddressTable        m_particles;      // of the event
+    std::vector<int>    m_listed_in;      // by particle: times listed as incoming by its end vertex
+    std::vector<int>    m_listed_out;     // by particle: times listed as outgoing by its production vertex
+    std::vector<int>    m_production;     // by particle: position of the vertex, or -1
+    std::vector<int>    m_end;
+    std::vector<int>    m_indegree;       // by vertex, for finding the loops
+    std::vector<int>    m_edge_offsets;
+    std::vector<int>    m_edges;
+    std::vector<int>    m_ready;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_INTEGRITY_CHECK_H
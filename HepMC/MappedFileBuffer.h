@@ -0,0 +1,67 @@
+#ifndef HEPMC_MAPPED_FILE_BUFFER_H
+#define HEPMC_MAPPED_FILE_BUFFER_H
+
+//////////////////////////////////////////////////////////////////////////
+// MappedFileBuffer.h
+//
+// Input stream buffer over a memory mapped file
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+namespace HepMC {
+
+  //! MappedFileBuffer lets an input stream read from a memory mapped file
+
+  ///
+  /// \class MappedFileBuffer
+  /// open() maps a whole file into memory and makes the mapping the get
+  /// area of the buffer, so that a std::istream on it reads the bytes of
+  /// the file where the kernel has put them: no read() calls, no copies
+  /// into a stream buffer, and no virtual calls to refill it. The kernel
+  /// is told that the file will be read from the start to the end.
+  ///
+  /// Only regular files can be mapped. open() returns false for pipes,
+  /// terminals and files which are too large for the address space, and
+  /// on systems without mmap (Windows); the caller then reads the file
+  /// with a std::ifstream instead, as IO_GenEvent does.
+  /// The file must not be truncated while it is mapped.
+  ///
+  class MappedFileBuffer : public std::streambuf {
+  public:
+    MappedFileBuffer();
+    virtual ~MappedFileBuffer();
+
+    /// map filename for reading, false if it cannot be mapped
+    bool open( const std::string& filename );
+    /// unmap the file
+    void close();
+    /// true if a file is mapped
+    bool is_open() const { return m_open; }
+    /// number of bytes of the file
+    std::size_t size() const { return m_size; }
+
+  protected:
+    /// the whole file is in the get area, so there is nothing more
+    int_type underflow();
+    std::streamsize showmanyc();
+    pos_type seekoff( off_type off, std::ios_base::seekdir dir,
+                      std::ios_base::openmode which = std::ios_base::in );
+    pos_type seekpos( pos_type pos,
+                      std::ios_base::openmode which = std::ios_base::in );
+
+  private: // copying is not allowed
+    MappedFileBuffer( const MappedFileBuffer& );
+    MappedFileBuffer& operator=( const MappedFileBuffer& );
+
+  private: // data members
+    char*        m_data;    // the mapping
+    std::size_t  m_size;
+    bool         m_open;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_MAPPED_FILE_BUFFER_H
@@ -0,0 +1,96 @@
+#ifndef HEPMC_MOMENTUM_BALANCE_H
+#define HEPMC_MOMENTUM_BALANCE_H
+
+//////////////////////////////////////////////////////////////////////////
+// MomentumBalance.h
+//
+// Four-momentum conservation at all vertices of an event
+//////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "HepMC/SimpleVector.h"
+
+namespace HepMC {
+
+  class GenEvent;
+  class GenEventColumns;
+
+  //! MomentumBalance checks four-momentum conservation at every vertex
+
+  ///
+  /// \class MomentumBalance
+  /// fill() adds up, for all vertices of an event, the four-momenta going
+  /// in minus the four-momenta coming out into one array per component,
+  /// and then tests all vertices in one pass over the arrays, which the
+  /// compiler can turn into vector instructions. The sums are made vertex
+  /// by vertex from a GenEvent, or in two passes over the particle columns
+  /// if a GenEventColumns is at hand. This replaces calling
+  /// GenVertex::check_momentum_conservation() for every vertex, which only
+  /// looks at the three-momentum, and grows linearly with the size of the
+  /// event.
+  ///
+  /// A vertex violates conservation if the energy or the magnitude of the
+  /// three-momentum of its imbalance exceeds tolerance times the energy
+  /// going in. Vertices without incoming or without outgoing particles in
+  /// the event cannot balance and are not tested.
+  ///
+  /// Vertex j is the j-th vertex of GenEvent::vertices_begin(), as in
+  /// GenEventColumns. The results do not change when the event does.
+  /// The object is meant to be refilled for every event and keeps its
+  /// capacity.
+  ///
+  class MomentumBalance {
+  public:
+    /// a vertex which violates conservation
+    struct Violation {
+      int        vertex;    // index of the vertex
+      int        barcode;   // of the vertex
+      FourVector imbalance; // momentum in minus momentum out
+    };
+
+    MomentumBalance();
+    /// balance of all vertices of evt
+    explicit MomentumBalance( const GenEvent& evt, double tolerance = 1.e-6 );
+
+    /// replace the contents by the balance of all vertices of evt
+    void fill( const GenEvent& evt, double tolerance = 1.e-6 );
+    /// replace the contents by the balance of all vertices of the
+    /// event in columns
+    void fill( const GenEventColumns& columns, double tolerance = 1.e-6 );
+    /// forget the event, keeping the capacity
+    void clear();
+
+    /// true if all vertices conserve four-momentum
+    bool conserved() const { return m_violations.empty(); }
+    /// the vertices which violate conservation, in vertex order
+    const std::vector<Violation>& violations() const { return m_violations; }
+
+    /// number of vertices
+    int vertices_size() const { return (int)m_dpx.size(); }
+    /// momentum in minus momentum out at vertex j
+    FourVector imbalance( int j ) const
+    { return FourVector( m_dpx[j], m_dpy[j], m_dpz[j], m_de[j] ); }
+
+  private:
+    /// size the arrays for nv vertices, with zero sums
+    void reset_( int nv );
+    /// compare the sums with the energy going in
+    void test_( double tolerance );
+
+  private: // data members
+    std::vector<double>  m_dpx;       // by vertex
+    std::vector<double>  m_dpy;
+    std::vector<double>  m_dpz;
+    std::vector<double>  m_de;
+    std::vector<double>  m_e_in;      // energy going in
+    std::vector<int>     m_in;        // number of particles going in
+    std::vector<int>     m_out;       // number of particles coming out
+    std::vector<int>     m_violated;
+    std::vector<int>     m_barcode;   // of the vertex
+    std::vector<Violation> m_violations;
+  };
+
+} // HepMC
+
+#endif  // HEPMC_MOMENTUM_BALANCE_H
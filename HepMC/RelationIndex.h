@@ -0,0 +1,136 @@
+#ifndef HEPMC_RELATION_INDEX_H
+#define HEPMC_RELATION_INDEX_H
+
+//////////////////////////////////////////////////////////////////////////
+// RelationIndex.h
+//
+// Ancestor and descendant relations of all particles of an event
+//////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace HepMC {
+
+  class GenEvent;
+  class GenParticle;
+  class GenVertex;
+
+  //! RelationIndex answers ancestor and descendant questions in constant time
+
+  ///
+  /// \class RelationIndex
+  /// fill() works out once, for every vertex of the event, which vertices
+  /// it comes from or leads to. Particle a is then an ancestor of
+  /// particle p if the end vertex of a is the production vertex of p or
+  /// one of the vertices it comes from, which is a single lookup instead
+  /// of a walk through GenParticle::ancestors().
+  ///
+  /// Events of up to bit_limit() vertices (4096 by default) keep one bit
+  /// per earlier vertex in GenEvent::ordered_vertices() for every vertex,
+  /// about V*V/16 bytes for V vertices, or 1 MB at the limit, and answer
+  /// with a bit test.
+  /// Larger events, such as heavy ion events, number the vertices in post
+  /// order along a spanning tree, in which every vertex hangs from one of
+  /// the vertices its incoming particles come from. The vertices a vertex
+  /// leads to are then the numbers of its subtree, plus those reached
+  /// through the vertices with several parents, kept as a short sorted
+  /// list of intervals per vertex. The lookup is a binary search in that
+  /// list, and the index grows with the number of vertices and of
+  /// intervals, which stays close to linear for generator events.
+  /// The particles are also sorted by PDG id, so that the ancestors of a
+  /// particle with a given id are found by testing only the particles with
+  /// that id.
+  ///
+  /// The relations are those of GenParticle::ancestors() and descendants(),
+  /// restricted to the particles and vertices of the event. They are exact
+  /// for events without loops.
+  ///
+  /// The index refers to the particles and vertices of the event, which
+  /// must not change while it is used. It is meant to be refilled for
+  /// every event and keeps its capacity.
+  ///
+  class RelationIndex {
+  public:
+    RelationIndex();
+    /// index of evt
+    explicit RelationIndex( const GenEvent& evt );
+
+    /// replace the contents by the index of evt
+    void fill( const GenEvent& evt );
+    /// the largest number of vertices for which bits are kept
+    std::size_t bit_limit() const { return m_bit_limit; }
+    /// keep bits for events of up to n vertices, and intervals for larger
+    /// ones, from the next fill() on
+    void set_bit_limit( std::size_t n ) { m_bit_limit = n; }
+    /// forget the event, keeping the capacity
+    void clear();
+
+    /// true if a is an ancestor of p
+    bool is_ancestor( const GenParticle* a, const GenParticle* p ) const;
+    /// true if d is a descendant of p
+    bool is_descendant( const GenParticle* d, const GenParticle* p ) const
+    { return is_ancestor( p, d ); }
+    /// true if vertex u comes before vertex v, that is if a particle
+    /// coming out of u leads to v
+    bool is_ancestor( const GenVertex* u, const GenVertex* v ) const;
+
+    /// true if p has an ancestor with this PDG id
+    bool has_ancestor( const GenParticle* p, int pdg_id ) const;
+    /// replace the contents of out by the ancestors of p with this PDG id,
+    /// in the order of GenEvent::particles_begin()
+    void ancestors( const GenParticle* p, int pdg_id,
+                    std::vector<GenParticle*>& out ) const;
+    /// replace the contents of out by the descendants of p with this PDG id,
+    /// in the order of GenEvent::particles_begin()
+    void descendants( const GenParticle* p, int pdg_id,
+                      std::vector<GenParticle*>& out ) const;
+
+  private:
+    typedef unsigned long Word;
+    /// a particle and the positions of its vertices in the causal order
+    struct Entry {
+      int          pdg_id;
+      int          production_vertex;
+      int          end_vertex;
+      GenParticle* particle;
+    };
+    struct ByPdgId {
+      bool operator()( const Entry& a, const Entry& b ) const { return a.pdg_id < b.pdg_id; }
+      bool operator()( const Entry& a, int id ) const { return a.pdg_id < id; }
+      bool operator()( int id, const Entry& b ) const { return id < b.pdg_id; }
+    };
+    typedef std::vector<Entry>::const_iterator EntryIterator;
+
+    typedef std::pair<int,int> Interval;  // first and last post order number
+
+    /// one bit per earlier vertex, for small events
+    void fill_bits();
+    /// post order numbers and intervals, for large events
+    void fill_intervals();
+    /// position of v in the causal order, or -1
+    int vertex_index( const GenVertex* v ) const;
+    /// true if vertex k is vertex j or comes before it
+    bool leads_to( int k, int j ) const;
+    /// the particles with this PDG id
+    std::pair<EntryIterator,EntryIterator> with_pdg_id( int pdg_id ) const;
+
+  private: // data members
+    const GenEvent*                 m_event;
+    std::vector<const GenVertex*>   m_vertices;   // in causal order
+    std::vector<std::size_t>        m_row;        // first word of the bits of vertex j
+    std::vector<Word>               m_bits;       // bit k of row j: k comes before j
+    std::vector<int>                m_post;       // post order number of vertex j
+    std::vector<std::size_t>        m_first_interval; // of vertex j in m_intervals
+    std::vector<Interval>           m_intervals;  // numbers of the vertices j leads to
+    std::size_t                     m_bit_limit;
+    int                             m_first_key;  // -barcode of m_slot[0]
+    std::vector<int>                m_slot;       // vertex index by -barcode, if dense
+    std::vector< std::pair<int,int> > m_sparse_slot; // otherwise, sorted by -barcode
+    std::vector<Entry>              m_by_pdg;     // sorted by PDG id
+  };
+
+} // HepMC
+
+#endif  // HEPMC_RELATION_INDEX_H
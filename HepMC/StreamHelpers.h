@@ -9,6 +9,7 @@
 
 #include <ostream>
 #include <istream>
+#include <string>
 
 #include "HepMC/GenEvent.h"
 #include "HepMC/TempParticleMap.h"
@@ -21,16 +22,73 @@ namespace HepMC {
     std::ostream & establish_output_stream_info( std::ostream & );
     /// Used by IO_GenEvent constructor
     std::istream & establish_input_stream_info( std::istream & );
+    /// Used by IO_GenEvent::seek_to_offset: the next event is read as
+    /// one of a listing of type io_type (see known_io in StreamInfo.h)
+    std::istream & resume_input_stream_info( std::istream &, int io_type,
+                                             bool has_key );
 
     /// Get a GenVertex from ASCII input
     ///
-    /// TempParticleMap is used to track the associations of particles with vertices
-    std::istream & read_vertex( std::istream &, TempParticleMap &, GenVertex * );
+    /// TempParticleMap is used to track the associations of particles with vertices.
+    /// The particles are allocated through GenEvent::create_particle if an event is given.
+    std::istream & read_vertex( std::istream &, TempParticleMap &, GenVertex *,
+                                GenEvent * evt = 0 );
+    /// Get a GenVertex from ASCII input, reading the lines into the given string
+    std::istream & read_vertex( std::istream &, TempParticleMap &, GenVertex *,
+                                GenEvent * evt, std::string & line );
 
     /// Get a GenParticle from ASCII input
     ///
     /// TempParticleMap is used to track the associations of particles with vertices
     std::istream & read_particle( std::istream&, TempParticleMap &, GenParticle * );
+    /// Get a GenParticle from ASCII input, reading the line into the given string
+    std::istream & read_particle( std::istream&, TempParticleMap &, GenParticle *,
+                                  std::string & line );
+
+    /// Reads the words and numbers of one line of ASCII input
+    ///
+    /// LineReader is used in place of a std::istringstream on the line.
+    /// It gives the same values and fails in the same places, but finds the
+    /// numbers itself instead of going through the locale of a stream, and
+    /// does not allocate. Once a read has failed, all further reads fail.
+    /// The line must outlive the reader.
+    class LineReader {
+    public:
+      explicit LineReader( const std::string & line )
+        : m_pos( line.data() ), m_end( line.data() + line.size() ),
+          m_begin( line.data() ), m_fail( false ), m_eof( false ) {}
+
+      LineReader & operator >> ( std::string & word );
+      LineReader & operator >> ( int & i );
+      LineReader & operator >> ( long & i );
+      LineReader & operator >> ( unsigned int & i );
+      LineReader & operator >> ( unsigned long & i );
+      LineReader & operator >> ( double & d );
+      LineReader & operator >> ( float & f );
+
+      /// true if a read has failed
+      bool operator ! () const { return m_fail; }
+      /// true if a read has reached the end of the line
+      bool eof() const { return m_eof; }
+
+    private:
+      /// skip blanks, false if there is nothing more to read
+      bool start_();
+      /// read the sign and digits of an integer
+      bool read_integer_( unsigned long & magnitude, bool & negative );
+      /// find a floating point number, false if there is none
+      bool scan_float_();
+
+      const char* m_pos;
+      const char* m_end;
+      const char* m_begin;  // of the last number found by scan_float_
+      bool        m_fail;
+      bool        m_eof;
+    };
+
+    /// true if line holds only blanks and the characters of numbers
+    /// from position pos on
+    bool numbers_only( const std::string & line, std::string::size_type pos );
 
     /// Write a double - for internal use by streaming IO
     inline std::ostream & output( std::ostream & os, const double& d ) {
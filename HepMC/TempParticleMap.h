@@ -9,7 +9,10 @@
 
 #include <HepMC/GenParticle.h>
 
+#include <algorithm>
 #include <map>
+#include <utility>
+#include <vector>
 
 namespace HepMC {
 
@@ -18,38 +21,92 @@ namespace HepMC {
 
   /// \class  TempParticleMap
   /// Used by IO classes for recoverable particle ordering.
-  /// Map GenParticle* against both outgoing vertex and particle order.
+  /// Holds the particles which have an end vertex, with the barcode of
+  /// that vertex, in a flat list in the order in which they are read.
+  /// order_begin() sorts the list by particle barcode when the particles
+  /// were not read in that order, so that the particles are connected to
+  /// their end vertices in the order of their barcodes.
+  /// Particles with the same barcode are all kept, in the order in which
+  /// they were added (the map used before HepMC 2.07 kept only the last).
+  ///
+  /// As before, it->first is the barcode and it->second the particle for
+  /// an orderIterator it, although orderIterator is no longer a map
+  /// iterator. The map of the particles to their end vertices behind
+  /// begin(), end() and end_vertex() is only built if they are used.
   ///
   class TempParticleMap {
   public:
-    typedef std::map<HepMC::GenParticle*,int> TempMap;
-    typedef std::map<int,HepMC::GenParticle*> TempOrderMap;
-    typedef TempMap::iterator     TempMapIterator;
-    typedef TempOrderMap::iterator  orderIterator;
+    /// (barcode of the particle when it was read, particle),
+    /// and the barcode of its end vertex
+    struct Entry : public std::pair<int,GenParticle*> {
+      int  end_vertex;
+    };
+    typedef std::vector<Entry>                 TempList;
+    typedef TempList::iterator                 orderIterator;
+    typedef std::map<HepMC::GenParticle*,int>  TempMap;
+    typedef TempMap::iterator                  TempMapIterator;
 
     TempParticleMap()
-      : m_particle_to_end_vertex(), m_particle_order()
+      : m_particles(), m_sorted(true), m_end_vertices(), m_mapped(true)
     { }
 
-    TempMapIterator begin() { return m_particle_to_end_vertex.begin(); }
-    TempMapIterator end() { return m_particle_to_end_vertex.end(); }
-    orderIterator order_begin() { return m_particle_order.begin(); }
-    orderIterator order_end() { return m_particle_order.end(); }
+    /// make room for n particles
+    void reserve( std::size_t n ) { m_particles.reserve( n ); }
+
+    /// the particles in the order of their barcodes
+    orderIterator order_begin() { sort(); return m_particles.begin(); }
+    orderIterator order_end() { return m_particles.end(); }
+    std::size_t size() const { return m_particles.size(); }
 
-    int end_vertex( GenParticle* p) {
-      return (m_particle_to_end_vertex.find(p) != end()) ? m_particle_to_end_vertex[p] : 0;
+    /// the particles and the barcodes of their end vertices, by particle
+    TempMapIterator begin() { fill_map(); return m_end_vertices.begin(); }
+    TempMapIterator end() { fill_map(); return m_end_vertices.end(); }
+    /// barcode of the end vertex of p, 0 if p was not added
+    int end_vertex( GenParticle* p ) {
+      fill_map();
+      TempMapIterator it = m_end_vertices.find( p );
+      return it != m_end_vertices.end() ? it->second : 0;
     }
 
     /// @todo Why pass the int by reference?
     void addEndParticle( GenParticle* p, int& end_vtx_code) {
-      m_particle_order[p->barcode()] = p;
-      m_particle_to_end_vertex[p] = end_vtx_code;
+      Entry entry;
+      entry.first = p->barcode();
+      entry.second = p;
+      entry.end_vertex = end_vtx_code;
+      if ( !m_particles.empty() && entry.first < m_particles.back().first ) {
+        m_sorted = false;
+      }
+      m_particles.push_back( entry );
+      m_mapped = false;
     }
 
   private:
+    struct BarcodeOrder {
+      bool operator()( const Entry& a, const Entry& b ) const
+      { return a.first < b.first; }
+    };
+
+    void sort() {
+      if ( m_sorted ) return;
+      std::stable_sort( m_particles.begin(), m_particles.end(), BarcodeOrder() );
+      m_sorted = true;
+    }
+
+    void fill_map() {
+      if ( m_mapped ) return;
+      m_end_vertices.clear();
+      for ( TempList::const_iterator it = m_particles.begin();
+            it != m_particles.end(); ++it ) {
+        m_end_vertices[ it->second ] = it->end_vertex;
+      }
+      m_mapped = true;
+    }
 
-    TempMap       m_particle_to_end_vertex;
-    TempOrderMap  m_particle_order;
+    TempList      m_particles;
+    bool          m_sorted;
+    TempMap       m_end_vertices; // built by fill_map() when asked for
+    bool          m_mapped;
 
   };
 
@@ -17,6 +17,8 @@
 #include <string>
 #include <algorithm>
 #include <map>
+#include <utility>
+#include "HepMC/HepMCDefs.h"
 namespace HepMC {
 
 
@@ -58,6 +60,13 @@ namespace HepMC {
       : m_weights(other.m_weights), m_names(other.m_names)
     {  }
 
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+    /// Move constructor, other is left empty
+    WeightContainer(WeightContainer&& other) noexcept
+      : m_weights(std::move(other.m_weights)), m_names(std::move(other.m_names))
+    { other.clear(); }
+#endif
+
 
     /// Copy assignment
     WeightContainer& operator = (const WeightContainer& wc) {
@@ -66,6 +75,15 @@ namespace HepMC {
       return *this;
     }
 
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+    /// Move assignment, wc is left empty
+    WeightContainer& operator = (WeightContainer&& wc) noexcept {
+      WeightContainer tmp(std::move(wc));
+      swap(tmp);
+      return *this;
+    }
+#endif
+
     /// Alternate assignment using a vector of doubles
     WeightContainer& operator = (const std::vector<double>& in) {
       WeightContainer tmp(in);
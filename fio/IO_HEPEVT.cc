@@ -60,7 +60,7 @@ namespace HepMC {
 	                                HEPEVT_Wrapper::number_entries()+1 );
 	hepevt_particle[0] = 0;
 	for ( int i1 = 1; i1 <= HEPEVT_Wrapper::number_entries(); ++i1 ) {
-	    hepevt_particle[i1] = build_particle(i1);
+	    hepevt_particle[i1] = build_particle(i1,evt);
 	}
 	std::set<GenVertex*> new_vertices;
 	//
@@ -99,7 +99,7 @@ namespace HepMC {
 	for ( int i3 = 1; i3 <= HEPEVT_Wrapper::number_entries(); ++i3 ) {
 	    if ( !hepevt_particle[i3]->end_vertex() &&
 			!hepevt_particle[i3]->production_vertex() ) {
-		GenVertex* prod_vtx = new GenVertex();
+		GenVertex* prod_vtx = evt->create_vertex();
 		prod_vtx->add_particle_out( hepevt_particle[i3] );
 		evt->add_vertex( prod_vtx );
 	    }
@@ -214,7 +214,7 @@ namespace HepMC {
 	if ( !prod_vtx && (HEPEVT_Wrapper::number_parents(i)>0
 			   || prod_pos!=FourVector(0,0,0,0)) )
 	{
-	    prod_vtx = new GenVertex();
+	    prod_vtx = evt->create_vertex();
 	    prod_vtx->add_particle_out( p );
 	    evt->add_vertex( prod_vtx );
 	}
@@ -272,7 +272,7 @@ namespace HepMC {
 	// b. (different from 3c. because HEPEVT particle can not know its
 	//        decay position )
 	if ( !end_vtx && HEPEVT_Wrapper::number_children(i)>0 ) {
-	    end_vtx = new GenVertex();
+	    end_vtx = evt->create_vertex();
 	    end_vtx->add_particle_in( p );
 	    evt->add_vertex( end_vtx );
 	}
@@ -322,15 +322,17 @@ namespace HepMC {
 	}
     }
 
-    GenParticle* IO_HEPEVT::build_particle( int index ) {
+    GenParticle* IO_HEPEVT::build_particle( int index, GenEvent* evt ) {
 	/// Builds a particle object corresponding to index in HEPEVT
 	//
-	GenParticle* p
-	    = new GenParticle( FourVector( HEPEVT_Wrapper::px(index),
-						 HEPEVT_Wrapper::py(index),
-						 HEPEVT_Wrapper::pz(index),
-						 HEPEVT_Wrapper::e(index) ),
-			       HEPEVT_Wrapper::id(index),
+	FourVector momentum( HEPEVT_Wrapper::px(index),
+			     HEPEVT_Wrapper::py(index),
+			     HEPEVT_Wrapper::pz(index),
+			     HEPEVT_Wrapper::e(index) );
+	GenParticle* p = evt
+	    ? evt->create_particle( momentum, HEPEVT_Wrapper::id(index),
+				    HEPEVT_Wrapper::status(index) )
+	    : new GenParticle( momentum, HEPEVT_Wrapper::id(index),
 			       HEPEVT_Wrapper::status(index) );
         p->set_generated_mass( HEPEVT_Wrapper::m(index) );
 	p->suggest_barcode( index );
@@ -0,0 +1,210 @@
+//////////////////////////////////////////////////////////////////////////
+// ChainIndex.cc
+//
+// Copies of the same particle, for going to the first and last copy
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <climits>
+
+#include "HepMC/ChainIndex.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  namespace {
+
+    typedef std::pair<int,const GenParticle*> IdEntry;
+
+    struct IdLess {
+      bool operator()( const IdEntry& a, const IdEntry& b ) const { return a.first < b.first; }
+    };
+
+    /// end of the run of entries with the same id as *b
+    std::vector<IdEntry>::const_iterator
+    run_end( std::vector<IdEntry>::const_iterator b, std::vector<IdEntry>::const_iterator e )
+    {
+      std::vector<IdEntry>::const_iterator r = b;
+      while ( r != e && r->first == b->first ) ++r;
+      return r;
+    }
+
+  } // unnamed namespace
+
+  ChainIndex::ChainIndex()
+    : m_particles(),
+      m_previous(),
+      m_next(),
+      m_first(),
+      m_last(),
+      m_last_copies(),
+      m_first_key(0),
+      m_slot(),
+      m_sparse_slot()
+  {}
+
+  ChainIndex::ChainIndex( const GenEvent& evt )
+    : m_particles(),
+      m_previous(),
+      m_next(),
+      m_first(),
+      m_last(),
+      m_last_copies(),
+      m_first_key(0),
+      m_slot(),
+      m_sparse_slot()
+  { fill( evt ); }
+
+  void ChainIndex::clear()
+  {
+    m_particles.clear();
+    m_previous.clear();
+    m_next.clear();
+    m_first.clear();
+    m_last.clear();
+    m_last_copies.clear();
+    m_first_key = 0;
+    m_slot.clear();
+    m_sparse_slot.clear();
+  }
+
+  void ChainIndex::fill( const GenEvent& evt )
+  {
+    clear();
+    m_particles.reserve( evt.particles_size() );
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p ) {
+      m_particles.push_back( *p );
+    }
+    const std::size_t np = m_particles.size();
+    //
+    // 1. the position of every particle, looked up by barcode: the
+    //    particle barcodes are usually dense, so a plain table does
+    int lo = INT_MAX;
+    int hi = INT_MIN;
+    for ( std::size_t i = 0; i < np; ++i ) {
+      const int key = m_particles[i]->barcode();
+      if ( key < lo ) lo = key;
+      if ( key > hi ) hi = key;
+    }
+    if ( np > 0 && (double)hi - lo < 2.*np + 64 ) {
+      m_first_key = lo;
+      m_slot.assign( hi - lo + 1, -1 );
+      for ( std::size_t i = 0; i < np; ++i ) {
+        m_slot[ m_particles[i]->barcode() - lo ] = (int)i;
+      }
+    } else {
+      m_sparse_slot.resize( np );
+      for ( std::size_t i = 0; i < np; ++i ) {
+        m_sparse_slot[i] = std::make_pair( m_particles[i]->barcode(), (int)i );
+      }
+      std::sort( m_sparse_slot.begin(), m_sparse_slot.end() );
+    }
+    //
+    // 2. the copies made at every vertex: a particle is copied if its id
+    //    occurs once among the incoming and once among the outgoing
+    //    particles; sorting both by id counts them in one pass
+    m_previous.assign( np, -1 );
+    m_next.assign( np, -1 );
+    std::vector<IdEntry> in_ids;
+    std::vector<IdEntry> out_ids;
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v ) {
+      in_ids.clear();
+      out_ids.clear();
+      for ( GenVertex::particles_in_const_iterator p = (*v)->particles_in_const_begin();
+            p != (*v)->particles_in_const_end(); ++p ) {
+        in_ids.push_back( IdEntry( (*p)->pdg_id(), *p ) );
+      }
+      if ( in_ids.empty() ) continue;
+      for ( GenVertex::particles_out_const_iterator p = (*v)->particles_out_const_begin();
+            p != (*v)->particles_out_const_end(); ++p ) {
+        out_ids.push_back( IdEntry( (*p)->pdg_id(), *p ) );
+      }
+      std::sort( in_ids.begin(), in_ids.end(), IdLess() );
+      std::sort( out_ids.begin(), out_ids.end(), IdLess() );
+      std::vector<IdEntry>::const_iterator in = in_ids.begin();
+      std::vector<IdEntry>::const_iterator out = out_ids.begin();
+      while ( in != in_ids.end() && out != out_ids.end() ) {
+        if ( in->first < out->first ) {
+          in = run_end( in, in_ids.end() );
+        } else if ( out->first < in->first ) {
+          out = run_end( out, out_ids.end() );
+        } else {
+          std::vector<IdEntry>::const_iterator in_end = run_end( in, in_ids.end() );
+          std::vector<IdEntry>::const_iterator out_end = run_end( out, out_ids.end() );
+          if ( in_end - in == 1 && out_end - out == 1 && in->second != out->second ) {
+            const int i = particle_index( in->second );
+            const int j = particle_index( out->second );
+            if ( i >= 0 && j >= 0 ) {
+              m_next[i] = j;
+              m_previous[j] = i;
+            }
+          }
+          in = in_end;
+          out = out_end;
+        }
+      }
+    }
+    //
+    // 3. the ends of every chain, followed from its first copy
+    m_first.assign( np, -1 );
+    m_last.assign( np, -1 );
+    for ( std::size_t i = 0; i < np; ++i ) {
+      if ( m_previous[i] != -1 ) continue;
+      int last = (int)i;
+      while ( m_next[last] != -1 ) last = m_next[last];
+      for ( int j = (int)i; j != -1; j = m_next[j] ) {
+        m_first[j] = (int)i;
+        m_last[j] = last;
+      }
+    }
+    // what is left are loops
+    for ( std::size_t i = 0; i < np; ++i ) {
+      if ( m_first[i] == -1 ) m_first[i] = m_last[i] = (int)i;
+      if ( m_last[i] == (int)i ) m_last_copies.push_back( m_particles[i] );
+    }
+  }
+
+  int ChainIndex::particle_index( const GenParticle* p ) const
+  {
+    if ( !p ) return -1;
+    const int key = p->barcode();
+    int i = -1;
+    if ( !m_slot.empty() ) {
+      const long k = (long)key - m_first_key;
+      if ( k >= 0 && k < (long)m_slot.size() ) i = m_slot[k];
+    } else {
+      std::vector< std::pair<int,int> >::const_iterator s =
+        std::lower_bound( m_sparse_slot.begin(), m_sparse_slot.end(),
+                          std::make_pair( key, INT_MIN ) );
+      if ( s != m_sparse_slot.end() && s->first == key ) i = s->second;
+    }
+    return ( i >= 0 && m_particles[i] == p ) ? i : -1;
+  }
+
+  GenParticle* ChainIndex::first_copy( const GenParticle* p ) const
+  {
+    const int i = particle_index( p );
+    return i < 0 ? 0 : m_particles[ m_first[i] ];
+  }
+
+  GenParticle* ChainIndex::last_copy( const GenParticle* p ) const
+  {
+    const int i = particle_index( p );
+    return i < 0 ? 0 : m_particles[ m_last[i] ];
+  }
+
+  GenParticle* ChainIndex::previous_copy( const GenParticle* p ) const
+  {
+    const int i = particle_index( p );
+    return i < 0 ? 0 : particle( m_previous[i] );
+  }
+
+  GenParticle* ChainIndex::next_copy( const GenParticle* p ) const
+  {
+    const int i = particle_index( p );
+    return i < 0 ? 0 : particle( m_next[i] );
+  }
+
+} // HepMC
@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////
+// EventArena.cc
+//
+// Block allocator for the particles and vertices of a single GenEvent
+//////////////////////////////////////////////////////////////////////////
+
+#include <new>
+
+#include "HepMC/EventArena.h"
+
+namespace HepMC {
+
+  namespace {
+
+    std::size_t round_up( std::size_t n )
+    {
+      const std::size_t a = EventArena::alignment();
+      return ( n + a - 1 ) / a * a;
+    }
+
+  } // unnamed namespace
+
+  EventArena::EventArena( std::size_t block_size )
+    : m_block_size( round_up(block_size) ),
+      m_blocks(),
+      m_current(0),
+      m_offset(0),
+      m_used(0),
+      m_reserved(0)
+  {}
+
+  EventArena::~EventArena()
+  {
+    release();
+  }
+
+  void* EventArena::allocate( std::size_t nbytes )
+  {
+    nbytes = round_up( nbytes );
+    // look for room in the current block, then in the blocks kept by reset()
+    while ( m_current < m_blocks.size() ) {
+      if ( m_offset + nbytes <= m_blocks[m_current].size ) {
+        void* p = m_blocks[m_current].data + m_offset;
+        m_offset += nbytes;
+        m_used += nbytes;
+        return p;
+      }
+      ++m_current;
+      m_offset = 0;
+    }
+    // no room anywhere: add a block, oversized requests get their own
+    Block b;
+    b.size = ( nbytes > m_block_size ) ? nbytes : m_block_size;
+    b.data = static_cast<char*>( ::operator new( b.size ) );
+    m_blocks.push_back( b );
+    m_reserved += b.size;
+    m_current = m_blocks.size() - 1;
+    m_offset = nbytes;
+    m_used += nbytes;
+    return b.data;
+  }
+
+  void EventArena::reset()
+  {
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+  }
+
+  void EventArena::release()
+  {
+    for ( std::vector<Block>::iterator b = m_blocks.begin();
+          b != m_blocks.end(); ++b ) {
+      ::operator delete( b->data );
+    }
+    m_blocks.clear();
+    m_reserved = 0;
+    reset();
+  }
+
+} // HepMC
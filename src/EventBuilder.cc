@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////
+// EventBuilder.cc
+//
+// Builds a GenEvent from flat tables of particles and vertices
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+
+#include "HepMC/EventBuilder.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  EventBuilder::EventBuilder()
+    : m_particles(),
+      m_vertices(),
+      m_signal_process_vertex(-1),
+      m_beam_particle_1(-1),
+      m_beam_particle_2(-1),
+      m_vertex_objects(),
+      m_barcodes()
+  {}
+
+  int EventBuilder::add_vertex( const FourVector& position, int status, int barcode )
+  {
+    Vertex v;
+    v.position = position;
+    v.status = status;
+    v.barcode = barcode;
+    m_vertices.push_back( v );
+    return (int)m_vertices.size() - 1;
+  }
+
+  int EventBuilder::add_particle( const FourVector& momentum, int pdg_id, int status,
+                                  int production_vertex, int end_vertex, int barcode )
+  {
+    Particle p;
+    p.momentum = momentum;
+    p.generated_mass = momentum.m();
+    p.pdg_id = pdg_id;
+    p.status = status;
+    p.production_vertex = production_vertex;
+    p.end_vertex = end_vertex;
+    p.barcode = barcode;
+    m_particles.push_back( p );
+    return (int)m_particles.size() - 1;
+  }
+
+  void EventBuilder::reserve( int nparticles, int nvertices )
+  {
+    m_particles.reserve( nparticles );
+    m_vertices.reserve( nvertices );
+  }
+
+  void EventBuilder::clear()
+  {
+    m_particles.clear();
+    m_vertices.clear();
+    m_signal_process_vertex = -1;
+    m_beam_particle_1 = -1;
+    m_beam_particle_2 = -1;
+  }
+
+  const char* EventBuilder::check() const
+  {
+    const int np = particles_size();
+    const int nv = vertices_size();
+    bool explicit_barcodes = false;
+    for ( int i = 0; i < np; ++i ) {
+      const Particle& p = m_particles[i];
+      if ( p.production_vertex < -1 || p.production_vertex >= nv ||
+           p.end_vertex < -1 || p.end_vertex >= nv ) {
+        return "vertex index out of range";
+      }
+      if ( p.production_vertex == -1 && p.end_vertex == -1 ) {
+        return "particle without production or end vertex";
+      }
+      if ( p.barcode < 0 ) return "negative particle barcode";
+      if ( p.barcode ) explicit_barcodes = true;
+    }
+    for ( int j = 0; j < nv; ++j ) {
+      if ( m_vertices[j].barcode > 0 ) return "positive vertex barcode";
+      if ( m_vertices[j].barcode ) explicit_barcodes = true;
+    }
+    if ( m_signal_process_vertex < -1 || m_signal_process_vertex >= nv ) {
+      return "signal process vertex index out of range";
+    }
+    if ( m_beam_particle_1 < -1 || m_beam_particle_1 >= np ||
+         m_beam_particle_2 < -1 || m_beam_particle_2 >= np ) {
+      return "beam particle index out of range";
+    }
+    // the default barcodes are unique by construction
+    if ( explicit_barcodes ) {
+      // particle barcodes are positive and vertex barcodes negative,
+      // so that they can be checked together
+      m_barcodes.resize( np + nv );
+      for ( int i = 0; i < np; ++i ) m_barcodes[i] = particle_barcode( i );
+      for ( int j = 0; j < nv; ++j ) m_barcodes[np+j] = vertex_barcode( j );
+      std::sort( m_barcodes.begin(), m_barcodes.end() );
+      if ( std::adjacent_find( m_barcodes.begin(), m_barcodes.end() ) != m_barcodes.end() ) {
+        return "barcode used more than once";
+      }
+    }
+    return 0;
+  }
+
+  bool EventBuilder::fill_event( GenEvent* evt ) const
+  {
+    if ( !evt ) return false;
+    const char* problem = check();
+    if ( problem ) {
+      std::cerr << "EventBuilder::fill_event ERROR " << problem
+                << ", the event is not filled" << std::endl;
+      return false;
+    }
+    evt->clear();
+    const int np = particles_size();
+    const int nv = vertices_size();
+    evt->m_vertex_barcodes.reserve( nv );
+    evt->m_particle_barcodes.reserve( np );
+    //
+    // 1. the vertices
+    m_vertex_objects.resize( nv );
+    for ( int j = 0; j < nv; ++j ) {
+      GenVertex* v = evt->create_vertex( m_vertices[j].position, m_vertices[j].status );
+      evt->adopt_vertex_( v, vertex_barcode( j ) );
+      m_vertex_objects[j] = v;
+    }
+    //
+    // 2. the particles, each attached to its vertices right away
+    for ( int i = 0; i < np; ++i ) {
+      const Particle& entry = m_particles[i];
+      GenParticle* p = evt->create_particle( entry.momentum, entry.pdg_id, entry.status );
+      p->set_generated_mass( entry.generated_mass );
+      evt->adopt_particle_( p, particle_barcode( i ) );
+      if ( entry.production_vertex != -1 ) {
+        GenEvent::attach_out_( m_vertex_objects[entry.production_vertex], p );
+      }
+      if ( entry.end_vertex != -1 ) {
+        GenEvent::attach_in_( m_vertex_objects[entry.end_vertex], p );
+      }
+    }
+    //
+    // 3. signal process vertex and beam particles
+    evt->m_signal_process_vertex = ( m_signal_process_vertex != -1 ) ?
+      m_vertex_objects[m_signal_process_vertex] : 0;
+    evt->set_beam_particles(
+      m_beam_particle_1 != -1 ? evt->barcode_to_particle( particle_barcode( m_beam_particle_1 ) ) : 0,
+      m_beam_particle_2 != -1 ? evt->barcode_to_particle( particle_barcode( m_beam_particle_2 ) ) : 0 );
+    return true;
+  }
+
+} // HepMC
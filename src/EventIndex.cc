@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////////
+// EventIndex.cc
+//
+// Positions of the events of an IO_GenEvent file, for random access
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "HepMC/EventIndex.h"
+#include "HepMC/StreamHelpers.h"
+#include "HepMC/StreamInfo.h"
+
+namespace HepMC {
+
+  namespace {
+
+    const char* const index_start = "HepMC::EventIndex-START_EVENT_INDEX";
+    const char* const index_end = "HepMC::EventIndex-END_EVENT_INDEX";
+
+    // the type of listing which line starts: known_io for event listings,
+    // -1 for other listings, 0 if it does not start a listing
+    int listing_start( const StreamInfo& info, const std::string& line )
+    {
+      if ( line == info.IO_GenEvent_Key() ) return gen;
+      if ( line == info.IO_Ascii_Key() ) return ascii;
+      if ( line == info.IO_ExtendedAscii_Key() ) return extascii;
+      if ( line == info.IO_Ascii_PDT_Key() ) return -1;
+      if ( line == info.IO_ExtendedAscii_PDT_Key() ) return -1;
+      return 0;
+    }
+
+    bool listing_end( const StreamInfo& info, const std::string& line )
+    {
+      return line == info.IO_GenEvent_End() || line == info.IO_Ascii_End()
+        || line == info.IO_ExtendedAscii_End() || line == info.IO_Ascii_PDT_End()
+        || line == info.IO_ExtendedAscii_PDT_End();
+    }
+
+    struct ByEventNumber {
+      bool operator()( const EventIndex::Entry& a, int number ) const
+      { return a.event_number < number; }
+    };
+
+  } // unnamed namespace
+
+  EventIndex::EventIndex()
+    : m_entries(),
+      m_ordered(true)
+  {}
+
+  EventIndex::EventIndex( std::istream& is )
+    : m_entries(),
+      m_ordered(true)
+  { build( is ); }
+
+  void EventIndex::clear()
+  {
+    m_entries.clear();
+    m_ordered = true;
+  }
+
+  void EventIndex::add( const Entry& entry )
+  {
+    if ( !m_entries.empty() && entry.event_number < m_entries.back().event_number ) {
+      m_ordered = false;
+    }
+    m_entries.push_back( entry );
+  }
+
+  bool EventIndex::build( std::istream& is )
+  {
+    clear();
+    std::streamoff offset = is.tellg();
+    if ( offset < 0 ) return false;
+    // the listings are found as GenEvent::read finds them: an "E" line
+    // starts a listing without a key at the start and after an end key
+    StreamInfo info;
+    int io_type = 0;      // of the current event listing
+    bool has_key = false;
+    bool keyless = true;
+    Entry* event = 0;     // the current event
+    std::string line;
+    while ( std::getline( is, line ) ) {
+      const std::streamoff start = offset;
+      offset += line.size() + ( is.eof() ? 0 : 1 );
+      const char first = line.empty() ? '\0' : line[0];
+      const bool may_be_keyless = keyless;
+      keyless = false;
+      if ( first == 'V' ) {
+        if ( event ) ++event->vertices;
+      } else if ( first == 'P' ) {
+        if ( event ) ++event->particles;
+      } else if ( first == 'E' ) {
+        if ( io_type == 0 && may_be_keyless ) {
+          io_type = gen;
+          has_key = false;
+        }
+        if ( io_type == 0 ) continue;
+        Entry entry;
+        entry.offset = start;
+        entry.io_type = io_type;
+        entry.has_key = has_key;
+        entry.event_number = 0;
+        entry.vertices = 0;
+        entry.particles = 0;
+        std::string type;
+        detail::LineReader iline( line );
+        iline >> type >> entry.event_number;
+        add( entry );
+        event = &m_entries.back();
+      } else if ( first == 'H' ) {
+        const int type = listing_start( info, line );
+        if ( type != 0 ) {
+          io_type = type > 0 ? type : 0;
+          has_key = true;
+          event = 0;
+        } else if ( listing_end( info, line ) ) {
+          io_type = 0;
+          keyless = true;
+          event = 0;
+        }
+      }
+    }
+    // the end of the input is not an error here
+    is.clear();
+    return true;
+  }
+
+  bool EventIndex::find( int event_number, std::size_t& n ) const
+  {
+    std::vector<Entry>::const_iterator it;
+    if ( m_ordered ) {
+      it = std::lower_bound( m_entries.begin(), m_entries.end(), event_number,
+                             ByEventNumber() );
+    } else {
+      for ( it = m_entries.begin(); it != m_entries.end(); ++it ) {
+        if ( it->event_number == event_number ) break;
+      }
+    }
+    if ( it == m_entries.end() || it->event_number != event_number ) return false;
+    n = it - m_entries.begin();
+    return true;
+  }
+
+  std::size_t EventIndex::split( int k, int nparts ) const
+  {
+    if ( k <= 0 || nparts <= 0 ) return 0;
+    if ( k >= nparts ) return m_entries.size();
+    double total = 0;
+    for ( std::size_t n = 0; n < m_entries.size(); ++n ) total += m_entries[n].particles;
+    // the first event after k/nparts of the particles
+    const double before = total * k / nparts;
+    double sum = 0;
+    std::size_t n = 0;
+    while ( n < m_entries.size() && sum + m_entries[n].particles <= before ) {
+      sum += m_entries[n].particles;
+      ++n;
+    }
+    return n;
+  }
+
+  std::ostream& EventIndex::write( std::ostream& os ) const
+  {
+    os << index_start << "\n";
+    for ( std::size_t n = 0; n < m_entries.size(); ++n ) {
+      const Entry& e = m_entries[n];
+      os << "I " << (long)e.offset << ' ' << e.io_type << ' ' << e.has_key
+         << ' ' << e.event_number << ' ' << e.vertices << ' ' << e.particles << "\n";
+    }
+    os << index_end << "\n";
+    return os;
+  }
+
+  bool EventIndex::read( std::istream& is )
+  {
+    clear();
+    std::string line;
+    if ( !std::getline( is, line ) || line != index_start ) return false;
+    while ( std::getline( is, line ) ) {
+      if ( line == index_end ) return true;
+      detail::LineReader iline( line );
+      std::string type;
+      long offset = 0;
+      int has_key = 0;
+      Entry entry;
+      iline >> type >> offset >> entry.io_type >> has_key
+            >> entry.event_number >> entry.vertices >> entry.particles;
+      if ( !iline || type != "I" ) break;
+      entry.offset = offset;
+      entry.has_key = has_key != 0;
+      add( entry );
+    }
+    clear();
+    return false;
+  }
+
+} // HepMC
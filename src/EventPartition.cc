@@ -0,0 +1,253 @@
+//////////////////////////////////////////////////////////////////////////
+// EventPartition.cc
+//
+// Independent parts of an event, for working on them in parallel
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <climits>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "HepMC/EventPartition.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  namespace {
+
+    // the representative of the set of vertex j, halving the path to it
+    int find_root( std::vector<int>& up, int j )
+    {
+      while ( up[j] != j ) {
+        up[j] = up[ up[j] ];
+        j = up[j];
+      }
+      return j;
+    }
+
+    // larger parts first, then in the order of their number
+    struct LargerPart {
+      const std::vector<int>* vertex_offsets;
+      const std::vector<int>* particle_offsets;
+      int size( int k ) const {
+        return (*vertex_offsets)[k+1] - (*vertex_offsets)[k]
+          + (*particle_offsets)[k+1] - (*particle_offsets)[k];
+      }
+      bool operator()( int a, int b ) const {
+        if ( size(a) != size(b) ) return size(a) > size(b);
+        return a < b;
+      }
+    };
+
+    // the parts still to be visited by for_each
+    struct Dispatch {
+      const EventPartition*      partition;
+      EventPartition::Visitor*   visitor;
+      const std::vector<int>*    order;
+      std::size_t                next;
+#ifndef _WIN32
+      pthread_mutex_t            lock;
+#endif
+    };
+
+    // the next part to visit, or -1 if there is none
+    int next_part( Dispatch& d )
+    {
+#ifndef _WIN32
+      pthread_mutex_lock( &d.lock );
+#endif
+      const int k = ( d.next < d.order->size() ) ? (*d.order)[ d.next++ ] : -1;
+#ifndef _WIN32
+      pthread_mutex_unlock( &d.lock );
+#endif
+      return k;
+    }
+
+    void visit_parts( Dispatch& d )
+    {
+      for ( int k = next_part( d ); k >= 0; k = next_part( d ) ) {
+        d.visitor->visit( d.partition->part( k ) );
+      }
+    }
+
+#ifndef _WIN32
+    void* visit_parts_thread( void* d )
+    {
+      visit_parts( *static_cast<Dispatch*>( d ) );
+      return 0;
+    }
+#endif
+
+  } // unnamed namespace
+
+  EventPartition::EventPartition()
+    : m_event(0),
+      m_vertices(),
+      m_vertex_offsets( 1, 0 ),
+      m_particles(),
+      m_particle_offsets( 1, 0 ),
+      m_part(),
+      m_vertex_index(),
+      m_by_size()
+  {}
+
+  EventPartition::EventPartition( const GenEvent& evt )
+    : m_event(0),
+      m_vertices(),
+      m_vertex_offsets( 1, 0 ),
+      m_particles(),
+      m_particle_offsets( 1, 0 ),
+      m_part(),
+      m_vertex_index(),
+      m_by_size()
+  { fill( evt ); }
+
+  void EventPartition::clear()
+  {
+    m_event = 0;
+    m_vertices.clear();
+    m_vertex_offsets.assign( 1, 0 );
+    m_particles.clear();
+    m_particle_offsets.assign( 1, 0 );
+    m_part.clear();
+    m_vertex_index.clear();
+    m_by_size.clear();
+  }
+
+  void EventPartition::fill( const GenEvent& evt )
+  {
+    clear();
+    m_event = &evt;
+    //
+    // 1. the vertices, looked up by address
+    std::vector<GenVertex*> vertices;
+    vertices.reserve( evt.vertices_size() );
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v ) {
+      m_vertex_index.push_back( std::make_pair( *v, (int)vertices.size() ) );
+      vertices.push_back( *v );
+    }
+    std::sort( m_vertex_index.begin(), m_vertex_index.end() );
+    const int nv = (int)vertices.size();
+    //
+    // 2. the vertices joined by the particles
+    std::vector<int> up( nv );
+    for ( int j = 0; j < nv; ++j ) up[j] = j;
+    std::vector<int> particle_vertex;
+    particle_vertex.reserve( evt.particles_size() );
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p ) {
+      const int prod = vertex_index( (*p)->production_vertex() );
+      const int end = vertex_index( (*p)->end_vertex() );
+      if ( prod >= 0 && end >= 0 ) {
+        const int a = find_root( up, prod );
+        const int b = find_root( up, end );
+        // the smaller position represents the set
+        if ( a < b ) up[b] = a;
+        else if ( b < a ) up[a] = b;
+      }
+      particle_vertex.push_back( prod >= 0 ? prod : end );
+    }
+    //
+    // 3. the parts, numbered in the order of their first vertex,
+    //    and their contents, sorted by part
+    m_part.resize( nv );
+    int nparts = 0;
+    for ( int j = 0; j < nv; ++j ) {
+      const int root = find_root( up, j );
+      m_part[j] = ( root == j ) ? nparts++ : m_part[root];
+    }
+    m_vertex_offsets.assign( nparts + 1, 0 );
+    m_particle_offsets.assign( nparts + 1, 0 );
+    for ( int j = 0; j < nv; ++j ) ++m_vertex_offsets[ m_part[j] + 1 ];
+    for ( std::size_t i = 0; i < particle_vertex.size(); ++i ) {
+      if ( particle_vertex[i] >= 0 ) ++m_particle_offsets[ m_part[ particle_vertex[i] ] + 1 ];
+    }
+    for ( int k = 0; k < nparts; ++k ) {
+      m_vertex_offsets[k+1] += m_vertex_offsets[k];
+      m_particle_offsets[k+1] += m_particle_offsets[k];
+    }
+    m_vertices.resize( nv );
+    m_particles.resize( m_particle_offsets[nparts] );
+    std::vector<int> fill_vertex( m_vertex_offsets.begin(), m_vertex_offsets.end() - 1 );
+    std::vector<int> fill_particle( m_particle_offsets.begin(), m_particle_offsets.end() - 1 );
+    for ( int j = 0; j < nv; ++j ) m_vertices[ fill_vertex[ m_part[j] ]++ ] = vertices[j];
+    int i = 0;
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p, ++i ) {
+      if ( particle_vertex[i] >= 0 ) m_particles[ fill_particle[ m_part[ particle_vertex[i] ] ]++ ] = *p;
+    }
+    //
+    // 4. the order in which for_each hands them out
+    m_by_size.resize( nparts );
+    for ( int k = 0; k < nparts; ++k ) m_by_size[k] = k;
+    LargerPart larger = { &m_vertex_offsets, &m_particle_offsets };
+    std::sort( m_by_size.begin(), m_by_size.end(), larger );
+  }
+
+  int EventPartition::vertex_index( const GenVertex* v ) const
+  {
+    if ( !v || !m_event || v->parent_event() != m_event ) return -1;
+    std::vector< std::pair<const GenVertex*,int> >::const_iterator i =
+      std::lower_bound( m_vertex_index.begin(), m_vertex_index.end(),
+                        std::make_pair( v, INT_MIN ) );
+    return ( i != m_vertex_index.end() && i->first == v ) ? i->second : -1;
+  }
+
+  int EventPartition::part_of( const GenVertex* v ) const
+  {
+    const int j = vertex_index( v );
+    return j < 0 ? -1 : m_part[j];
+  }
+
+  EventPartition::Part EventPartition::part( int k ) const
+  {
+    GenVertex* const* v = m_vertices.empty() ? 0 : &m_vertices[0];
+    GenParticle* const* p = m_particles.empty() ? 0 : &m_particles[0];
+    return Part( k, v + m_vertex_offsets[k], v + m_vertex_offsets[k+1],
+                 p + m_particle_offsets[k], p + m_particle_offsets[k+1] );
+  }
+
+  void EventPartition::for_each( Visitor& visitor, int nthreads ) const
+  {
+    if ( !m_event || size() == 0 ) return;
+    Dispatch d;
+    d.partition = this;
+    d.visitor = &visitor;
+    d.order = &m_by_size;
+    d.next = 0;
+    m_event->begin_shared_reading();
+#ifndef _WIN32
+    pthread_mutex_init( &d.lock, 0 );
+    std::vector<pthread_t> threads;
+    const int nworkers = std::min( nthreads, size() ) - 1;
+    for ( int t = 0; t < nworkers; ++t ) {
+      pthread_t thread;
+      // if no more threads can be started, the others do the work
+      if ( pthread_create( &thread, 0, visit_parts_thread, &d ) != 0 ) break;
+      threads.push_back( thread );
+    }
+#endif
+    try {
+      visit_parts( d );
+    } catch ( ... ) {
+      // the other threads must not go on with d
+#ifndef _WIN32
+      pthread_mutex_lock( &d.lock );
+      d.next = m_by_size.size();
+      pthread_mutex_unlock( &d.lock );
+      for ( std::size_t t = 0; t < threads.size(); ++t ) pthread_join( threads[t], 0 );
+      pthread_mutex_destroy( &d.lock );
+#endif
+      throw;
+    }
+#ifndef _WIN32
+    for ( std::size_t t = 0; t < threads.size(); ++t ) pthread_join( threads[t], 0 );
+    pthread_mutex_destroy( &d.lock );
+#endif
+  }
+
+} // HepMC
@@ -11,24 +11,91 @@
 namespace HepMC {
 
   Flow::Flow( GenParticle* particle_owner )
-    : m_particle_owner(particle_owner)
+    : m_particle_owner(particle_owner), m_more(0), m_size(0)
   {}
 
   Flow::Flow( const Flow& inflow ) :
-    m_particle_owner(inflow.m_particle_owner),
-    m_icode(inflow.m_icode)
+    m_particle_owner(inflow.m_particle_owner), m_more(0), m_size(0)
   {
-    /// copies both the m_icode AND the m_particle_owner
+    /// copies both the flow codes AND the m_particle_owner
+    if ( inflow.m_more ) {
+      m_more = new std::vector<value_type>( *inflow.m_more );
+    } else {
+      for ( ; m_size != inflow.m_size; ++m_size ) {
+        m_inline[m_size] = inflow.m_inline[m_size];
+      }
+    }
   }
 
   Flow::~Flow() {
-    m_icode.clear();
+    delete m_more;
   }
 
   void Flow::swap( Flow & other)
   {
     std::swap( m_particle_owner, other.m_particle_owner );
-    m_icode.swap( other.m_icode );
+    swap_codes( other );
+  }
+
+  void Flow::swap_codes( Flow & other )
+  {
+    std::swap( m_more, other.m_more );
+    std::swap( m_size, other.m_size );
+    for ( int i = 0; i != inline_size; ++i ) {
+      std::swap( m_inline[i], other.m_inline[i] );
+    }
+  }
+
+  Flow Flow::set_icode( int code_index, int code ) {
+    iterator a = begin();
+    for ( ; a != end() && a->first < code_index; ++a ) {}
+    if ( a != end() && a->first == code_index ) {
+      a->second = code;
+    } else if ( m_more ) {
+      m_more->insert( m_more->begin() + ( a - begin() ),
+                      value_type( code_index, code ) );
+    } else if ( m_size < inline_size ) {
+      // keep the inline patterns sorted by code index
+      for ( iterator b = end(); b != a; --b ) *b = *(b-1);
+      *a = value_type( code_index, code );
+      ++m_size;
+    } else {
+      // the third pattern moves all of them out of line
+      m_more = new std::vector<value_type>( begin(), a );
+      m_more->push_back( value_type( code_index, code ) );
+      m_more->insert( m_more->end(), a, m_inline + m_size );
+      m_size = 0;
+    }
+    return *this;
+  }
+
+  void Flow::clear() {
+    delete m_more;
+    m_more = 0;
+    m_size = 0;
+  }
+
+  bool Flow::erase( int code_index ) {
+    // this will return true if the number of elements removed is nonzero
+    iterator a = begin();
+    for ( ; a != end() && a->first != code_index; ++a ) {}
+    if ( a == end() ) return false;
+    if ( m_more ) {
+      m_more->erase( m_more->begin() + ( a - begin() ) );
+      if ( m_more->size() <= (std::size_t)inline_size ) {
+        // move the remaining patterns back inline
+        std::vector<value_type>* more = m_more;
+        m_more = 0;
+        for ( m_size = 0; m_size != (int)more->size(); ++m_size ) {
+          m_inline[m_size] = (*more)[m_size];
+        }
+        delete more;
+      }
+    } else {
+      for ( ; a+1 != end(); ++a ) *a = *(a+1);
+      --m_size;
+    }
+    return true;
   }
 
   void Flow::print( std::ostream& ostr ) const {
@@ -188,9 +255,8 @@ namespace HepMC {
 
   /// send Flow informatin to ostr for printing
   std::ostream& operator<<( std::ostream& ostr, const Flow& f ) {
-    ostr << f.m_icode.size();
-    for ( std::map<int,int>::const_iterator i = f.m_icode.begin();
-          i != f.m_icode.end(); ++i ) {
+    ostr << f.size();
+    for ( Flow::const_iterator i = f.begin(); i != f.end(); ++i ) {
       ostr << " " << (*i).first << " " << (*i).second;
     }
     return ostr;
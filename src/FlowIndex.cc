@@ -0,0 +1,188 @@
+//////////////////////////////////////////////////////////////////////////
+// FlowIndex.cc
+//
+// Flow codes of all particles of an event, for finding flow partners
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <climits>
+
+#include "HepMC/FlowIndex.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  FlowIndex::FlowIndex()
+    : m_event(0),
+      m_entries(),
+      m_nodes(),
+      m_attached(),
+      m_total(),
+      m_reached(),
+      m_queue()
+  {}
+
+  FlowIndex::FlowIndex( const GenEvent& evt )
+    : m_event(0),
+      m_entries(),
+      m_nodes(),
+      m_attached(),
+      m_total(),
+      m_reached(),
+      m_queue()
+  { fill( evt ); }
+
+  void FlowIndex::clear()
+  {
+    m_event = 0;
+    m_entries.clear();
+  }
+
+  void FlowIndex::fill( const GenEvent& evt )
+  {
+    clear();
+    m_event = &evt;
+    int position = 0;
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p, ++position ) {
+      const Flow& flow = (*p)->flow();
+      for ( Flow::const_iterator f = flow.begin(); f != flow.end(); ++f ) {
+        Entry entry;
+        entry.code = f->second;
+        entry.code_index = f->first;
+        entry.position = position;
+        entry.particle = *p;
+        m_entries.push_back( entry );
+      }
+    }
+    std::sort( m_entries.begin(), m_entries.end() );
+  }
+
+  bool FlowIndex::connect( const GenParticle* p, int code, int code_index,
+                           int num_indices ) const
+  {
+    if ( !p || !m_event || p->parent_event() != m_event || num_indices <= 0 ) return false;
+    bool carries = false;
+    for ( int i = code_index; i != code_index + num_indices; ++i ) {
+      if ( p->flow( i ) == code ) carries = true;
+    }
+    if ( !carries ) return false;
+    //
+    // 1. the particles with the code in one of the code indices,
+    //    counting the indices
+    Entry first;
+    first.code = code;
+    first.code_index = code_index;
+    first.position = INT_MIN;
+    Entry last = first;
+    last.code_index = code_index + num_indices;
+    std::vector<Entry>::const_iterator lo =
+      std::lower_bound( m_entries.begin(), m_entries.end(), first );
+    std::vector<Entry>::const_iterator hi =
+      std::lower_bound( lo, m_entries.end(), last );
+    m_nodes.clear();
+    for ( std::vector<Entry>::const_iterator e = lo; e != hi; ++e ) {
+      Node node;
+      node.position = e->position;
+      node.matches = 1;
+      node.particle = e->particle;
+      m_nodes.push_back( node );
+    }
+    std::sort( m_nodes.begin(), m_nodes.end() );
+    std::size_t n = 0;
+    for ( std::size_t k = 0; k < m_nodes.size(); ++k ) {
+      if ( n > 0 && m_nodes[n-1].particle == m_nodes[k].particle ) {
+        ++m_nodes[n-1].matches;
+      } else {
+        m_nodes[n++] = m_nodes[k];
+      }
+    }
+    m_nodes.resize( n );
+    //
+    // 2. the vertices they are attached to, with the number of matches
+    //    at every vertex for counting the partners
+    m_attached.clear();
+    int start = -1;
+    for ( std::size_t k = 0; k < n; ++k ) {
+      const GenParticle* q = m_nodes[k].particle;
+      if ( q == p ) start = (int)k;
+      if ( q->production_vertex() ) m_attached.push_back( Attachment( q->production_vertex(), (int)k ) );
+      if ( q->end_vertex() ) m_attached.push_back( Attachment( q->end_vertex(), (int)k ) );
+    }
+    // p is not in the index if its flow has changed since
+    if ( start < 0 ) return false;
+    std::sort( m_attached.begin(), m_attached.end() );
+    m_total.resize( m_attached.size() );
+    for ( std::size_t a = 0; a < m_attached.size(); ) {
+      std::size_t b = a;
+      int total = 0;
+      for ( ; b < m_attached.size() && m_attached[b].first == m_attached[a].first; ++b ) {
+        total += m_nodes[ m_attached[b].second ].matches;
+      }
+      for ( ; a < b; ++a ) m_total[a] = total;
+    }
+    //
+    // 3. the particles reached from p through shared vertices
+    m_reached.assign( n, 0 );
+    m_queue.clear();
+    m_reached[start] = 1;
+    m_queue.push_back( start );
+    for ( std::size_t k = 0; k < m_queue.size(); ++k ) {
+      const GenParticle* q = m_nodes[ m_queue[k] ].particle;
+      const GenVertex* ends[2] = { q->end_vertex(), q->production_vertex() };
+      for ( int side = 0; side < 2; ++side ) {
+        if ( !ends[side] ) continue;
+        for ( std::vector<Attachment>::const_iterator a =
+                std::lower_bound( m_attached.begin(), m_attached.end(),
+                                  Attachment( ends[side], -1 ) );
+              a != m_attached.end() && a->first == ends[side]; ++a ) {
+          if ( !m_reached[ a->second ] ) {
+            m_reached[ a->second ] = 1;
+            m_queue.push_back( a->second );
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  std::vector<GenParticle*> FlowIndex::connected_partners( const GenParticle* p, int code,
+                                                           int code_index,
+                                                           int num_indices ) const
+  {
+    std::vector<GenParticle*> output;
+    if ( !connect( p, code, code_index, num_indices ) ) return output;
+    output.reserve( m_queue.size() );
+    for ( std::size_t k = 0; k < m_nodes.size(); ++k ) {
+      if ( m_reached[k] ) output.push_back( m_nodes[k].particle );
+    }
+    return output;
+  }
+
+  std::vector<GenParticle*> FlowIndex::dangling_connected_partners( const GenParticle* p, int code,
+                                                                    int code_index,
+                                                                    int num_indices ) const
+  {
+    std::vector<GenParticle*> output;
+    if ( !connect( p, code, code_index, num_indices ) ) return output;
+    for ( std::size_t k = 0; k < m_nodes.size(); ++k ) {
+      if ( !m_reached[k] ) continue;
+      // the partners are counted as in Flow: once for every code index
+      // with the code, at the end and at the production vertex
+      const GenParticle* q = m_nodes[k].particle;
+      const GenVertex* ends[2] = { q->end_vertex(), q->production_vertex() };
+      const int own = ( ends[0] == ends[1] ? 2 : 1 ) * m_nodes[k].matches;
+      int partners = 0;
+      for ( int side = 0; side < 2; ++side ) {
+        if ( !ends[side] ) continue;
+        std::vector<Attachment>::const_iterator a =
+          std::lower_bound( m_attached.begin(), m_attached.end(),
+                            Attachment( ends[side], -1 ) );
+        partners += m_total[ a - m_attached.begin() ] - own;
+      }
+      if ( partners <= 1 ) output.push_back( m_nodes[k].particle );
+    }
+    return output;
+  }
+
+} // HepMC
@@ -7,9 +7,9 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
-#include <sstream>
 
 #include "HepMC/GenCrossSection.h"
+#include "HepMC/StreamHelpers.h"
 #include "HepMC/IO_Exception.h"
 
 namespace HepMC {
@@ -87,7 +87,7 @@ namespace HepMC {
     // get the GenCrossSection line
     std::string line, firstc;
     std::getline(is,line);
-    std::istringstream iline(line);
+    detail::LineReader iline(line);
     // Get first character and throw it away
     iline >> firstc;
     // Now get the numbers
@@ -10,9 +10,12 @@
 // Event record for MC generators (for use at any stage of generation)
 //////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iomanip>
+#include <typeinfo>
 
 #include "HepMC/GenEvent.h"
+#include "HepMC/EventArena.h"
 #include "HepMC/GenCrossSection.h"
 #include "HepMC/Version.h"
 #include "HepMC/StreamHelpers.h"
@@ -40,11 +43,25 @@ namespace HepMC {
     m_random_states(random_states),
     m_vertex_barcodes(),
     m_particle_barcodes(),
+    m_defer_barcodes(false),
+    m_deferred_particles(),
+    m_deferred_vertices(),
+    m_deferred_particles_waiting(0),
+    m_deferred_vertices_waiting(0),
     m_cross_section(0),
     m_heavy_ion(0),
     m_pdf_info(0),
     m_momentum_unit(mom),
-    m_position_unit(len)
+    m_position_unit(len),
+    m_arena(0),
+    m_use_arena(false),
+    m_free_particles(),
+    m_free_vertices(),
+    m_recycle(false),
+    m_vertex_order(),
+    m_vertex_order_valid(false),
+    m_beam_1_in_event(false),
+    m_beam_2_in_event(false)
   {
     /// This constructor only allows null pointers to HeavyIon and PdfInfo
     ///
@@ -75,11 +92,25 @@ namespace HepMC {
     m_random_states(random_states),
     m_vertex_barcodes(),
     m_particle_barcodes(),
+    m_defer_barcodes(false),
+    m_deferred_particles(),
+    m_deferred_vertices(),
+    m_deferred_particles_waiting(0),
+    m_deferred_vertices_waiting(0),
     m_cross_section(0),
     m_heavy_ion( new HeavyIon(ion) ),
     m_pdf_info( new PdfInfo(pdf) ),
     m_momentum_unit(mom),
-    m_position_unit(len)
+    m_position_unit(len),
+    m_arena(0),
+    m_use_arena(false),
+    m_free_particles(),
+    m_free_vertices(),
+    m_recycle(false),
+    m_vertex_order(),
+    m_vertex_order_valid(false),
+    m_beam_1_in_event(false),
+    m_beam_2_in_event(false)
   {
     /// GenEvent makes its own copy of HeavyIon and PdfInfo
     ///
@@ -108,11 +139,25 @@ namespace HepMC {
     m_random_states(random_states),
     m_vertex_barcodes(),
     m_particle_barcodes(),
+    m_defer_barcodes(false),
+    m_deferred_particles(),
+    m_deferred_vertices(),
+    m_deferred_particles_waiting(0),
+    m_deferred_vertices_waiting(0),
     m_cross_section(0),
     m_heavy_ion(0),
     m_pdf_info(0),
     m_momentum_unit(mom),
-    m_position_unit(len)
+    m_position_unit(len),
+    m_arena(0),
+    m_use_arena(false),
+    m_free_particles(),
+    m_free_vertices(),
+    m_recycle(false),
+    m_vertex_order(),
+    m_vertex_order_valid(false),
+    m_beam_1_in_event(false),
+    m_beam_2_in_event(false)
   {
     /// constructor requiring units - all else is default
     /// This constructor only allows null pointers to HeavyIon and PdfInfo
@@ -144,11 +189,25 @@ namespace HepMC {
     m_random_states(random_states),
     m_vertex_barcodes(),
     m_particle_barcodes(),
+    m_defer_barcodes(false),
+    m_deferred_particles(),
+    m_deferred_vertices(),
+    m_deferred_particles_waiting(0),
+    m_deferred_vertices_waiting(0),
     m_cross_section(0),
     m_heavy_ion( new HeavyIon(ion) ),
     m_pdf_info( new PdfInfo(pdf) ),
     m_momentum_unit(mom),
-    m_position_unit(len)
+    m_position_unit(len),
+    m_arena(0),
+    m_use_arena(false),
+    m_free_particles(),
+    m_free_vertices(),
+    m_recycle(false),
+    m_vertex_order(),
+    m_vertex_order_valid(false),
+    m_beam_1_in_event(false),
+    m_beam_2_in_event(false)
   {
     /// explicit constructor with units first that takes HeavyIon and PdfInfo
     /// GenEvent makes its own copy of HeavyIon and PdfInfo
@@ -172,63 +231,151 @@ namespace HepMC {
       m_random_states        ( /* inevent.m_random_states */ ),
       m_vertex_barcodes      ( /* inevent.m_vertex_barcodes */ ),
       m_particle_barcodes    ( /* inevent.m_particle_barcodes */ ),
+      m_defer_barcodes       ( inevent.defers_barcodes() ),
+      m_deferred_particles   (),
+      m_deferred_vertices    (),
+      m_deferred_particles_waiting( 0 ),
+      m_deferred_vertices_waiting( 0 ),
       m_cross_section        ( inevent.cross_section() ? new GenCrossSection(*inevent.cross_section()) : 0 ),
       m_heavy_ion            ( inevent.heavy_ion() ? new HeavyIon(*inevent.heavy_ion()) : 0 ),
       m_pdf_info             ( inevent.pdf_info() ? new PdfInfo(*inevent.pdf_info()) : 0 ),
       m_momentum_unit        ( inevent.momentum_unit() ),
-      m_position_unit        ( inevent.length_unit() )
+      m_position_unit        ( inevent.length_unit() ),
+      m_arena                ( 0 ),
+      m_use_arena            ( inevent.uses_arena() ),
+      m_free_particles       (),
+      m_free_vertices        (),
+      m_recycle              ( inevent.recycles_objects() ),
+      m_vertex_order         (),
+      m_vertex_order_valid   ( false ),
+      m_beam_1_in_event      ( false ),
+      m_beam_2_in_event      ( false )
   {
     /// deep copy - makes a copy of all vertices!
     //
+    copy_graph_( inevent );
+  }
+
+
+  void GenEvent::copy_header_( const GenEvent& inevent ) {
+    /// copies the event information of inevent into this cleared event,
+    /// except for the weights and random states, which go with the graph
+    m_signal_process_id = inevent.signal_process_id();
+    m_event_number = inevent.event_number();
+    m_mpi = inevent.mpi();
+    m_event_scale = inevent.event_scale();
+    m_alphaQCD = inevent.alphaQCD();
+    m_alphaQED = inevent.alphaQED();
+    if ( inevent.cross_section() ) set_cross_section( *inevent.cross_section() );
+    if ( inevent.heavy_ion() ) set_heavy_ion( *inevent.heavy_ion() );
+    if ( inevent.pdf_info() ) set_pdf_info( *inevent.pdf_info() );
+    m_momentum_unit = inevent.momentum_unit();
+    m_position_unit = inevent.length_unit();
+  }
+
 
-    // 1. create a NEW copy of all vertices from inevent
-    //    taking care to map new vertices onto the vertices being copied
-    //    and add these new vertices to this event.
+  void GenEvent::copy_graph_( const GenEvent& inevent ) {
+    /// copies the vertices, particles, weights and random states
+    /// of inevent into this (empty) event
+
+    // The copy is made in one pass over the vertices and one over the
+    // particles, without GenEvent::set_barcode() for each of them:
+    // the copies keep the barcodes of the originals and are entered in
+    // the barcode indices in key order, which only appends to them.
+    // The copied particles are then found through the (dense) barcode index.
+    //
+    // 1. create a NEW copy of all vertices from inevent, in index order.
     //    We do not use GenVertex::operator= because that would copy
     //    the attached particles as well.
-    std::map<const GenVertex*,GenVertex*> map_in_to_new;
+    m_vertex_barcodes.reserve( inevent.vertices_size() );
     for ( GenEvent::vertex_const_iterator v = inevent.vertices_begin();
           v != inevent.vertices_end(); ++v ) {
-      GenVertex* newvertex = new GenVertex( (*v)->position(), (*v)->status(), (*v)->weights() );
-      newvertex->suggest_barcode( (*v)->barcode() );
-      map_in_to_new[*v] = newvertex;
-      add_vertex( newvertex );
-    }
-    // 2. copy the signal process vertex info.
-    if ( inevent.signal_process_vertex() ) {
-      set_signal_process_vertex(
-                                map_in_to_new[inevent.signal_process_vertex()] );
-    } else set_signal_process_vertex( 0 );
+      GenVertex* newvertex = create_vertex( (*v)->position(), (*v)->status(), (*v)->weights() );
+      reserve_particles_( newvertex, (*v)->particles_in_size(), (*v)->particles_out_size() );
+      adopt_vertex_( newvertex, (*v)->barcode() );
+    }
     //
-    // 3. create a NEW copy of all particles from inevent
-    //    taking care to attach them to the appropriate vertex
-    GenParticle* beam1(0);
-    GenParticle* beam2(0);
+    // 2. create a NEW copy of all particles from inevent
+    m_particle_barcodes.reserve( inevent.particles_size() );
     for ( GenEvent::particle_const_iterator p = inevent.particles_begin();
-          p != inevent.particles_end(); ++p )
-      {
-        GenParticle* oldparticle = *p;
-        GenParticle* newparticle = new GenParticle(*oldparticle);
-        if ( oldparticle->end_vertex() ) {
-          map_in_to_new[ oldparticle->end_vertex() ]->
-            add_particle_in(newparticle);
-        }
-        if ( oldparticle->production_vertex() ) {
-          map_in_to_new[ oldparticle->production_vertex() ]->
-            add_particle_out(newparticle);
-        }
-        if ( oldparticle == inevent.beam_particles().first ) beam1 = newparticle;
-        if ( oldparticle == inevent.beam_particles().second ) beam2 = newparticle;
+          p != inevent.particles_end(); ++p ) {
+      adopt_particle_( create_particle(**p), (*p)->barcode() );
+    }
+    //
+    // 3. attach the particles to the appropriate vertices,
+    //    in the same order as in inevent
+    GenEvent::vertex_iterator newvertex = vertices_begin();
+    for ( GenEvent::vertex_const_iterator v = inevent.vertices_begin();
+          v != inevent.vertices_end(); ++v, ++newvertex ) {
+      const std::vector<GenParticle*>& in = (*v)->particles_in();
+      for ( std::vector<GenParticle*>::const_iterator p = in.begin(); p != in.end(); ++p ) {
+        attach_in_( *newvertex, m_particle_barcodes.find( (*p)->barcode() ) );
       }
-    set_beam_particles( beam1, beam2 );
+      const std::vector<GenParticle*>& out = (*v)->particles_out();
+      for ( std::vector<GenParticle*>::const_iterator p = out.begin(); p != out.end(); ++p ) {
+        attach_out_( *newvertex, m_particle_barcodes.find( (*p)->barcode() ) );
+      }
+    }
     //
-    // 4. now that vtx/particles are copied, copy weights and random states
+    // 4. copy the signal process vertex and beam particle info.
+    const GenVertex* signal = inevent.signal_process_vertex();
+    m_signal_process_vertex = ( signal && signal->parent_event() == &inevent ) ?
+      m_vertex_barcodes.find( -signal->barcode() ) : 0;
+    const GenParticle* beam1 = inevent.beam_particles().first;
+    const GenParticle* beam2 = inevent.beam_particles().second;
+    set_beam_particles(
+      beam1 && inevent.barcode_to_particle( beam1->barcode() ) == beam1 ?
+        m_particle_barcodes.find( beam1->barcode() ) : 0,
+      beam2 && inevent.barcode_to_particle( beam2->barcode() ) == beam2 ?
+        m_particle_barcodes.find( beam2->barcode() ) : 0 );
+    //
+    // 5. now that vtx/particles are copied, copy weights and random states
     set_random_states( inevent.random_states() );
-    weights() = inevent.weights();
+    m_weights.m_weights = inevent.weights().m_weights;
+    m_weights.m_names = inevent.weights().m_names;
+  }
+
+
+  void GenEvent::adopt_vertex_( GenVertex* v, int barcode ) {
+    v->m_barcode = barcode;
+    v->m_event = this;
+    m_vertex_barcodes.set( -barcode, v );
+    m_vertex_order_valid = false;
+  }
+
+
+  void GenEvent::adopt_particle_( GenParticle* p, int barcode ) {
+    if ( p == m_beam_particle_1 ) m_beam_1_in_event = true;
+    if ( p == m_beam_particle_2 ) m_beam_2_in_event = true;
+    p->m_barcode = barcode;
+    m_particle_barcodes.set( barcode, p );
+  }
+
+
+  void GenEvent::attach_in_( GenVertex* v, GenParticle* p ) {
+    p->m_end_vertex = v;
+    v->m_particles_in.push_back( p );
+    if ( v->m_event ) v->m_event->m_vertex_order_valid = false;
+  }
+
+
+  void GenEvent::attach_out_( GenVertex* v, GenParticle* p ) {
+    p->m_production_vertex = v;
+    v->m_particles_out.push_back( p );
+    if ( v->m_event ) v->m_event->m_vertex_order_valid = false;
+  }
+
+
+  void GenEvent::reserve_particles_( GenVertex* v, int nin, int nout ) {
+    v->m_particles_in.reserve( nin );
+    v->m_particles_out.reserve( nout );
   }
 
 
   void GenEvent::swap( GenEvent & other ) {
+    // the vertex back pointers are fixed below by iterating over the index
+    assign_barcodes();
+    other.assign_barcodes();
     // if a container has a swap method, use that for improved performance
     std::swap(m_signal_process_id    , other.m_signal_process_id    );
     std::swap(m_event_number         , other.m_event_number         );
@@ -243,11 +390,24 @@ namespace HepMC {
     m_random_states.swap(     other.m_random_states  );
     m_vertex_barcodes.swap(   other.m_vertex_barcodes );
     m_particle_barcodes.swap( other.m_particle_barcodes );
+    std::swap(m_defer_barcodes       , other.m_defer_barcodes       );
     std::swap(m_cross_section        , other.m_cross_section        );
     std::swap(m_heavy_ion            , other.m_heavy_ion            );
     std::swap(m_pdf_info             , other.m_pdf_info             );
     std::swap(m_momentum_unit       , other.m_momentum_unit       );
     std::swap(m_position_unit       , other.m_position_unit       );
+    // the arena travels with the particles and vertices allocated from it
+    std::swap(m_arena                , other.m_arena                );
+    std::swap(m_use_arena            , other.m_use_arena            );
+    // and so do the objects kept for reuse, which may live in the arena
+    m_free_particles.swap(    other.m_free_particles );
+    m_free_vertices.swap(     other.m_free_vertices );
+    std::swap(m_recycle              , other.m_recycle              );
+    // the vertices keep their order
+    m_vertex_order.swap(      other.m_vertex_order );
+    std::swap(m_vertex_order_valid   , other.m_vertex_order_valid   );
+    std::swap(m_beam_1_in_event      , other.m_beam_1_in_event      );
+    std::swap(m_beam_2_in_event      , other.m_beam_2_in_event      );
     // must now adjust GenVertex back pointers
     for ( GenEvent::vertex_const_iterator vthis = vertices_begin();
           vthis != vertices_end(); ++vthis ) {
@@ -265,13 +425,24 @@ namespace HepMC {
     /// deletes all vertices/particles in this GenEvent
     /// deletes the associated HeavyIon and PdfInfo
     delete_all_vertices();
+    delete_recycled_objects();
     delete m_cross_section;
     delete m_heavy_ion;
     delete m_pdf_info;
+    delete m_arena;
   }
 
 
   GenEvent& GenEvent::operator=( const GenEvent& inevent ) {
+    /// A recycling event rebuilds itself from the objects it keeps,
+    /// and keeps its own allocation settings.
+    if ( m_recycle ) {
+      if ( this == &inevent ) return *this;
+      clear();
+      copy_header_( inevent );
+      copy_graph_( inevent );
+      return *this;
+    }
     /// best practices implementation
     GenEvent tmp( inevent );
     swap( tmp );
@@ -378,16 +549,19 @@ namespace HepMC {
     // setting the vertex parent also inserts the vertex into this
     // event
     vtx->set_parent_event_( this );
-    return ( m_vertex_barcodes.count(vtx->barcode()) ? true : false );
+    // a vertex without barcode is waiting for a deferred one
+    if ( vtx->m_barcode == 0 ) return true;
+    return ( m_vertex_barcodes.count(-vtx->m_barcode) ? true : false );
   }
 
 
   bool GenEvent::remove_vertex( GenVertex* vtx ) {
     /// this removes vtx from the event but does NOT delete it.
     /// returns True if an entry vtx existed in the table and was erased
+    /// (the signal process vertex is reset by remove_barcode)
     if ( m_signal_process_vertex == vtx ) m_signal_process_vertex = 0;
     if ( vtx->parent_event() == this ) vtx->set_parent_event_( 0 );
-    return ( m_vertex_barcodes.count(vtx->barcode()) ? false : true );
+    return ( m_vertex_barcodes.count(-vtx->barcode()) ? false : true );
   }
 
 
@@ -395,7 +569,22 @@ namespace HepMC {
     /// remove all information from the event
     /// deletes all vertices/particles in this evt
     ///
-    delete_all_vertices();
+    if ( m_recycle ) {
+      recycle_all_vertices();
+    } else {
+      delete_all_vertices();
+    }
+    // all arena objects are gone now, so the arena can be recycled,
+    // unless it holds the objects kept for reuse
+    if ( m_arena && !( m_recycle && m_use_arena ) ) {
+      delete_recycled_objects();
+      if ( m_use_arena ) {
+        m_arena->reset();
+      } else {
+        delete m_arena;
+        m_arena = 0;
+      }
+    }
     // remove existing objects and set pointers to null
     delete m_cross_section;
     m_cross_section = 0;
@@ -404,15 +593,19 @@ namespace HepMC {
     delete m_pdf_info;
     m_pdf_info = 0;
     m_signal_process_id = 0;
+    m_signal_process_vertex = 0;
     m_beam_particle_1 = 0;
     m_beam_particle_2 = 0;
+    m_beam_1_in_event = false;
+    m_beam_2_in_event = false;
     m_event_number = 0;
     m_mpi = -1;
     m_event_scale = -1;
     m_alphaQCD = -1;
     m_alphaQED = -1;
-    m_weights = std::vector<double>();
-    m_random_states = std::vector<long>();
+    // keep the capacity for the next event
+    m_weights.clear();
+    m_random_states.clear();
     // resetting unit information
     m_momentum_unit = Units::default_momentum_unit();
     m_position_unit = Units::default_length_unit();
@@ -429,6 +622,85 @@ namespace HepMC {
   }
 
 
+  GenParticle* GenEvent::create_particle() {
+    if ( !m_free_particles.empty() ) {
+      // recycled particles are already in the default state
+      GenParticle* p = m_free_particles.back();
+      m_free_particles.pop_back();
+      return p;
+    }
+    if ( !m_use_arena ) return new GenParticle();
+    if ( !m_arena ) m_arena = new EventArena();
+    GenParticle* p = new( *m_arena ) GenParticle();
+    p->m_in_arena = 1;
+    return p;
+  }
+
+
+  GenParticle* GenEvent::create_particle( const FourVector& momentum,
+                                          int pdg_id, int status ) {
+    if ( !m_free_particles.empty() ) {
+      GenParticle* p = m_free_particles.back();
+      m_free_particles.pop_back();
+      const unsigned in_arena = p->m_in_arena;
+      p->GenParticle::~GenParticle();
+      p = new( p ) GenParticle( momentum, pdg_id, status );
+      p->m_in_arena = in_arena;
+      return p;
+    }
+    if ( !m_use_arena ) return new GenParticle( momentum, pdg_id, status );
+    if ( !m_arena ) m_arena = new EventArena();
+    GenParticle* p = new( *m_arena ) GenParticle( momentum, pdg_id, status );
+    p->m_in_arena = 1;
+    return p;
+  }
+
+
+  GenParticle* GenEvent::create_particle( const GenParticle& inparticle ) {
+    if ( !m_free_particles.empty() ) {
+      GenParticle* p = m_free_particles.back();
+      m_free_particles.pop_back();
+      const unsigned in_arena = p->m_in_arena;
+      p->GenParticle::~GenParticle();
+      p = new( p ) GenParticle( inparticle );
+      p->m_in_arena = in_arena;
+      return p;
+    }
+    if ( !m_use_arena ) return new GenParticle( inparticle );
+    if ( !m_arena ) m_arena = new EventArena();
+    GenParticle* p = new( *m_arena ) GenParticle( inparticle );
+    p->m_in_arena = 1;
+    return p;
+  }
+
+
+  GenVertex* GenEvent::create_vertex( const FourVector& position, int status,
+                                      const WeightContainer& weights ) {
+    if ( !m_free_vertices.empty() ) {
+      // a recycled vertex is detached and empty, but its containers
+      // still have their capacity, so fill it in place
+      GenVertex* v = m_free_vertices.back();
+      m_free_vertices.pop_back();
+      v->m_position = position;
+      v->m_status = status;
+      v->m_weights.m_weights = weights.m_weights;
+      v->m_weights.m_names = weights.m_names;
+      return v;
+    }
+    if ( !m_use_arena ) return new GenVertex( position, status, weights );
+    if ( !m_arena ) m_arena = new EventArena();
+    GenVertex* v = new( *m_arena ) GenVertex( position, status, weights );
+    v->m_in_arena = true;
+    return v;
+  }
+
+
+  void GenEvent::recycle_objects( bool on ) {
+    m_recycle = on;
+    if ( !on ) delete_recycled_objects();
+  }
+
+
   void GenEvent::delete_all_vertices() {
     /// deletes all vertices in the vertex container
     /// (i.e. all vertices owned by this event)
@@ -436,10 +708,15 @@ namespace HepMC {
     ///   the vertices, the vertex desctructors are automatically
     ///   deleting their particles.
 
+    // every vertex must be in the index
+    assign_barcodes();
+    m_vertex_order_valid = false;
     // delete each vertex individually (this deletes particles as well)
     while ( !vertices_empty() ) {
-      GenVertex* vtx = ( m_vertex_barcodes.begin() )->second;
-      m_vertex_barcodes.erase( m_vertex_barcodes.begin() );
+      detail::BarcodeIndex<GenVertex>::const_iterator first
+        = m_vertex_barcodes.begin();
+      GenVertex* vtx = *first;
+      m_vertex_barcodes.erase( first.key() );
       delete vtx;
     }
     //
@@ -457,6 +734,83 @@ namespace HepMC {
   }
 
 
+  void GenEvent::recycle_all_vertices() {
+    /// detaches all vertices and particles owned by this event and keeps
+    /// them for reuse by create_vertex() and create_particle()
+    /// Ownership is decided exactly as in delete_all_vertices, only the
+    /// objects which would have been deleted are recycled instead.
+    /// Classes derived from GenParticle or GenVertex are deleted as usual.
+    assign_barcodes();
+    m_vertex_order_valid = false;
+    // the particles are detached without remove_barcode()
+    m_beam_1_in_event = false;
+    m_beam_2_in_event = false;
+    for ( detail::BarcodeIndex<GenVertex>::const_iterator iv
+            = m_vertex_barcodes.begin();
+          iv != m_vertex_barcodes.end(); ++iv ) {
+      GenVertex* vtx = *iv;
+      for ( std::vector<GenParticle*>::iterator p = vtx->m_particles_out.begin();
+            p != vtx->m_particles_out.end(); ++p ) {
+        if ( (*p)->end_vertex() ) {
+          (*p)->set_production_vertex_( 0 );
+        } else {
+          (*p)->m_production_vertex = 0;
+          recycle_particle_( *p );
+        }
+      }
+      vtx->m_particles_out.clear();
+      for ( std::vector<GenParticle*>::iterator p = vtx->m_particles_in.begin();
+            p != vtx->m_particles_in.end(); ++p ) {
+        if ( (*p)->production_vertex() ) {
+          (*p)->set_end_vertex_( 0 );
+        } else {
+          (*p)->m_end_vertex = 0;
+          recycle_particle_( *p );
+        }
+      }
+      vtx->m_particles_in.clear();
+      vtx->m_event = 0;
+      vtx->m_barcode = 0;
+      if ( typeid( *vtx ) == typeid( GenVertex ) ) {
+        vtx->m_weights.clear();
+        m_free_vertices.push_back( vtx );
+      } else {
+        delete vtx;
+      }
+    }
+    m_vertex_barcodes.clear();
+    m_particle_barcodes.clear();
+  }
+
+
+  void GenEvent::recycle_particle_( GenParticle* p ) {
+    // p is detached from its vertices
+    if ( typeid( *p ) == typeid( GenParticle ) ) {
+      // the new particle occupies the same storage, so keeps its origin
+      const unsigned in_arena = p->m_in_arena;
+      p->GenParticle::~GenParticle();
+      m_free_particles.push_back( new( p ) GenParticle() );
+      m_free_particles.back()->m_in_arena = in_arena;
+    } else {
+      delete p;
+    }
+  }
+
+
+  void GenEvent::delete_recycled_objects() {
+    for ( std::vector<GenParticle*>::iterator p = m_free_particles.begin();
+          p != m_free_particles.end(); ++p ) {
+      delete *p;
+    }
+    m_free_particles.clear();
+    for ( std::vector<GenVertex*>::iterator v = m_free_vertices.begin();
+          v != m_free_vertices.end(); ++v ) {
+      delete *v;
+    }
+    m_free_vertices.clear();
+  }
+
+
   bool GenEvent::set_barcode( GenParticle* p, int suggested_barcode ) {
     if ( p->parent_event() != this ) {
       std::cerr << "GenEvent::set_barcode attempted, but the argument's"
@@ -464,18 +818,28 @@ namespace HepMC {
                 << std::endl;
       return false;
     }
+    // a beam particle which was set before it came into the event
+    if ( p == m_beam_particle_1 ) m_beam_1_in_event = true;
+    if ( p == m_beam_particle_2 ) m_beam_2_in_event = true;
     // M.Dobbs  Nov 4, 2002
     // First we must check to see if the particle already has a
     // barcode which is different from the suggestion. If yes, we
     // remove it from the particle map.
-    if ( p->barcode() != 0 && p->barcode() != suggested_barcode ) {
-      if ( m_particle_barcodes.count(p->barcode()) &&
-           m_particle_barcodes[p->barcode()] == p ) {
-        m_particle_barcodes.erase( p->barcode() );
-      }
+    if ( p->m_barcode != 0 && p->m_barcode != suggested_barcode ) {
+      m_particle_barcodes.erase( p->m_barcode, p );
       // At this point either the particle is NOT in
       // m_particle_barcodes, or else it is in the map, but
       // already with the suggested barcode.
+    } else if ( p->m_barcode == 0 && suggested_barcode != 0 ) {
+      // p may be waiting for a deferred barcode, it gets this one instead
+      replace_deferred_( p, 0 );
+    }
+    //
+    // With deferred barcodes, the automatic barcode is given later
+    if ( suggested_barcode == 0 && m_defer_barcodes ) {
+      p->set_barcode_( 0 );
+      defer_( p );
+      return true;
     }
     //
     // First case --- a valid barcode has been suggested
@@ -484,7 +848,7 @@ namespace HepMC {
     if ( suggested_barcode > 0 ) {
       if ( m_particle_barcodes.count(suggested_barcode) ) {
         // the suggested_barcode is already used.
-        if ( m_particle_barcodes[suggested_barcode] == p ) {
+        if ( m_particle_barcodes.find(suggested_barcode) == p ) {
           // but it was used for this particle ... so everythings ok
           p->set_barcode_( suggested_barcode );
           return true;
@@ -492,7 +856,7 @@ namespace HepMC {
         insert_success = false;
         suggested_barcode = 0;
       } else { // suggested barcode is OK, proceed to insert
-        m_particle_barcodes[suggested_barcode] = p;
+        m_particle_barcodes.set( suggested_barcode, p );
         p->set_barcode_( suggested_barcode );
         return true;
       }
@@ -505,7 +869,7 @@ namespace HepMC {
       if ( !m_particle_barcodes.empty() ) {
         // in this case we find the highest barcode that was used,
         // and increment it by 1
-        suggested_barcode = m_particle_barcodes.rbegin()->first;
+        suggested_barcode = m_particle_barcodes.max_key();
         ++suggested_barcode;
       }
       // For the automatically assigned barcodes, the first one
@@ -523,7 +887,7 @@ namespace HepMC {
                 << "happen \n report bug to matt.dobbs@cern.ch"
                 << std::endl;
     }
-    m_particle_barcodes[suggested_barcode] = p;
+    m_particle_barcodes.set( suggested_barcode, p );
     p->set_barcode_( suggested_barcode );
     return insert_success;
   }
@@ -536,18 +900,28 @@ namespace HepMC {
                 << std::endl;
       return false;
     }
+    // the order follows the barcodes
+    m_vertex_order_valid = false;
     // M.Dobbs Nov 4, 2002
     // First we must check to see if the vertex already has a
     // barcode which is different from the suggestion. If yes, we
     // remove it from the vertex map.
-    if ( v->barcode() != 0 && v->barcode() != suggested_barcode ) {
-      if ( m_vertex_barcodes.count(v->barcode()) &&
-           m_vertex_barcodes[v->barcode()] == v ) {
-        m_vertex_barcodes.erase( v->barcode() );
-      }
+    if ( v->m_barcode != 0 && v->m_barcode != suggested_barcode ) {
+      // (the vertex index is keyed by minus the barcode)
+      m_vertex_barcodes.erase( -v->m_barcode, v );
       // At this point either the vertex is NOT in
       // m_vertex_barcodes, or else it is in the map, but
       // already with the suggested barcode.
+    } else if ( v->m_barcode == 0 && suggested_barcode != 0 ) {
+      // v may be waiting for a deferred barcode, it gets this one instead
+      replace_deferred_( v, 0 );
+    }
+    //
+    // With deferred barcodes, the automatic barcode is given later
+    if ( suggested_barcode == 0 && m_defer_barcodes ) {
+      v->set_barcode_( 0 );
+      defer_( v );
+      return true;
     }
 
     //
@@ -555,9 +929,9 @@ namespace HepMC {
     //     (valid barcodes are numbers greater than zero)
     bool insert_success = true;
     if ( suggested_barcode < 0 ) {
-      if ( m_vertex_barcodes.count(suggested_barcode) ) {
+      if ( m_vertex_barcodes.count(-suggested_barcode) ) {
         // the suggested_barcode is already used.
-        if ( m_vertex_barcodes[suggested_barcode] == v ) {
+        if ( m_vertex_barcodes.find(-suggested_barcode) == v ) {
           // but it was used for this vertex ... so everythings ok
           v->set_barcode_( suggested_barcode );
           return true;
@@ -565,7 +939,7 @@ namespace HepMC {
         insert_success = false;
         suggested_barcode = 0;
       } else { // suggested barcode is OK, proceed to insert
-        m_vertex_barcodes[suggested_barcode] = v;
+        m_vertex_barcodes.set( -suggested_barcode, v );
         v->set_barcode_( suggested_barcode );
         return true;
       }
@@ -578,38 +952,210 @@ namespace HepMC {
       if ( !m_vertex_barcodes.empty() ) {
         // in this case we find the highest barcode that was used,
         // and increment it by 1, (vertex barcodes are negative)
-        suggested_barcode = m_vertex_barcodes.rbegin()->first;
+        suggested_barcode = -m_vertex_barcodes.max_key();
         --suggested_barcode;
       }
       if ( suggested_barcode >= 0 ) suggested_barcode = -1;
     }
     // At this point we should have a valid barcode
-    if ( m_vertex_barcodes.count(suggested_barcode) ) {
+    if ( m_vertex_barcodes.count(-suggested_barcode) ) {
       std::cerr << "GenEvent::set_barcode ERROR, this should never "
                 << "happen \n report bug to matt.dobbs@cern.ch"
                 << std::endl;
     }
-    m_vertex_barcodes[suggested_barcode] = v;
+    m_vertex_barcodes.set( -suggested_barcode, v );
     v->set_barcode_( suggested_barcode );
     return insert_success;
   }
 
 
-  /// test to see if we have two valid beam particles
-  bool  GenEvent::valid_beam_particles() const {
-    bool have1 = false;
-    bool have2 = false;
-    // first check that both are defined
-    if(m_beam_particle_1 && m_beam_particle_2) {
-      // now look for a match with the particle "list"
-      for ( particle_const_iterator p = particles_begin();
-            p != particles_end(); ++p ) {
-        if( m_beam_particle_1 == *p ) have1 = true;
-        if( m_beam_particle_2 == *p ) have2 = true;
+  void GenEvent::remove_barcode( GenParticle* p ) {
+    // p leaves the event, or is deleted
+    if ( p == m_beam_particle_1 ) m_beam_1_in_event = false;
+    if ( p == m_beam_particle_2 ) m_beam_2_in_event = false;
+    if ( p->m_barcode != 0 ) {
+      m_particle_barcodes.erase( p->m_barcode, p );
+    } else {
+      replace_deferred_( p, 0 );
+    }
+  }
+
+
+  void GenEvent::remove_barcode( GenVertex* v ) {
+    m_vertex_order_valid = false;
+    // v leaves the event, or is deleted
+    if ( v == m_signal_process_vertex ) m_signal_process_vertex = 0;
+    if ( v->m_barcode != 0 ) {
+      m_vertex_barcodes.erase( -v->m_barcode, v );
+    } else {
+      replace_deferred_( v, 0 );
+    }
+  }
+
+
+  void GenEvent::defer_barcodes( bool on ) {
+    if ( !on ) assign_barcodes();
+    m_defer_barcodes = on;
+  }
+
+
+  void GenEvent::assign_deferred_barcodes_() const {
+    /// The waiting particles and vertices get consecutive barcodes after
+    /// the largest ones in use, in the order in which they were added,
+    /// starting from 10001 and -1 like in set_barcode().
+    /// Entries which have been removed from the lists are null, and
+    /// objects which have been given a barcode since are skipped.
+    /// This is the only const function which fills the (mutable) barcode
+    /// indices, see begin_shared_reading().
+    int bc = m_particle_barcodes.max_key();
+    if ( bc < 10000 ) bc = 10000;
+    for ( std::vector<GenParticle*>::const_iterator p = m_deferred_particles.begin();
+          p != m_deferred_particles.end(); ++p ) {
+      if ( !*p || (*p)->m_barcode != 0 ) continue;
+      (*p)->set_barcode_( ++bc );
+      m_particle_barcodes.set( bc, *p );
+    }
+    m_deferred_particles.clear();
+    m_deferred_particles_waiting = 0;
+    // (the vertex index is keyed by minus the barcode)
+    int key = m_vertex_barcodes.max_key();
+    if ( key < 0 ) key = 0;
+    for ( std::vector<GenVertex*>::const_iterator v = m_deferred_vertices.begin();
+          v != m_deferred_vertices.end(); ++v ) {
+      if ( !*v || (*v)->m_barcode != 0 ) continue;
+      (*v)->set_barcode_( -(++key) );
+      m_vertex_barcodes.set( key, *v );
+    }
+    m_deferred_vertices.clear();
+    m_deferred_vertices_waiting = 0;
+  }
+
+
+  void GenEvent::begin_shared_reading() const {
+    /// does the work which the const functions keep for later, so that
+    /// they do not write to the event any more; once it is done, this
+    /// only reads the event as well
+    assign_barcodes();
+    ordered_vertices();
+  }
+
+
+  void GenEvent::order_vertices_() const {
+    /// The vertices are sorted topologically (Kahn's algorithm),
+    /// taking into account only particles between two different vertices
+    /// of this event, and then by depth.
+    /// Until a vertex is placed, its m_depth holds -1 minus the number of
+    /// particles coming into it from vertices which are not placed yet.
+    m_vertex_order.clear();
+    m_vertex_order.reserve( vertices_size() );
+    for ( vertex_const_iterator v = vertices_begin(); v != vertices_end(); ++v ) {
+      int waiting = 0;
+      for ( std::vector<GenParticle*>::const_iterator p = (*v)->m_particles_in.begin();
+            p != (*v)->m_particles_in.end(); ++p ) {
+        const GenVertex* prod = (*p)->m_production_vertex;
+        if ( prod && prod != *v && prod->m_event == this ) ++waiting;
       }
+      (*v)->m_depth = -1 - waiting;
+      if ( waiting == 0 ) m_vertex_order.push_back( *v );
     }
-    if( have1 && have2 ) return true;
-    return false;
+    // the placed vertices, in the order they were placed, form the queue
+    int max_depth = -1;
+    for ( std::size_t k = 0; k < m_vertex_order.size(); ++k ) {
+      GenVertex* v = m_vertex_order[k];
+      int depth = 0;
+      for ( std::vector<GenParticle*>::const_iterator p = v->m_particles_in.begin();
+            p != v->m_particles_in.end(); ++p ) {
+        const GenVertex* prod = (*p)->m_production_vertex;
+        if ( prod && prod != v && prod->m_event == this && prod->m_depth >= depth ) {
+          depth = prod->m_depth + 1;
+        }
+      }
+      v->m_depth = depth;
+      if ( depth > max_depth ) max_depth = depth;
+      for ( std::vector<GenParticle*>::const_iterator p = v->m_particles_out.begin();
+            p != v->m_particles_out.end(); ++p ) {
+        GenVertex* end = (*p)->m_end_vertex;
+        if ( end && end != v && end->m_event == this && end->m_depth < -1 ) {
+          if ( ++end->m_depth == -1 ) m_vertex_order.push_back( end );
+        }
+      }
+    }
+    //
+    // sort by depth, keeping the order of the index within each depth;
+    // the vertices on a loop were never placed and go to the end
+    std::vector<std::size_t> start( max_depth + 3, 0 );
+    for ( vertex_const_iterator v = vertices_begin(); v != vertices_end(); ++v ) {
+      if ( (*v)->m_depth < -1 ) (*v)->m_depth = -1;
+      ++start[ (*v)->m_depth >= 0 ? (*v)->m_depth + 1 : max_depth + 2 ];
+    }
+    for ( std::size_t d = 1; d < start.size(); ++d ) start[d] += start[d-1];
+    m_vertex_order.resize( vertices_size() );
+    for ( vertex_const_iterator v = vertices_begin(); v != vertices_end(); ++v ) {
+      const int d = (*v)->m_depth >= 0 ? (*v)->m_depth : max_depth + 1;
+      m_vertex_order[ start[d]++ ] = *v;
+    }
+    m_vertex_order_valid = true;
+  }
+
+
+  void GenEvent::defer_( GenParticle* p ) {
+    /// each object is in the list once, and remembers its place in it,
+    /// so that replace_deferred_() does not search the list
+    const int slot = p->m_deferred_slot;
+    if ( slot >= 0 && (std::size_t)slot < m_deferred_particles.size()
+         && m_deferred_particles[slot] == p ) return;
+    p->m_deferred_slot = (int)m_deferred_particles.size();
+    m_deferred_particles.push_back( p );
+    ++m_deferred_particles_waiting;
+  }
+
+
+  void GenEvent::defer_( GenVertex* v ) {
+    const int slot = v->m_deferred_slot;
+    if ( slot >= 0 && (std::size_t)slot < m_deferred_vertices.size()
+         && m_deferred_vertices[slot] == v ) return;
+    v->m_deferred_slot = (int)m_deferred_vertices.size();
+    m_deferred_vertices.push_back( v );
+    ++m_deferred_vertices_waiting;
+  }
+
+
+  void GenEvent::replace_deferred_( const GenParticle* old, GenParticle* obj ) {
+    /// the place old remembers is only taken as long as old is there,
+    /// it may be left over from another event or an earlier list
+    const int slot = old->m_deferred_slot;
+    if ( slot < 0 || (std::size_t)slot >= m_deferred_particles.size()
+         || m_deferred_particles[slot] != old ) return;
+    m_deferred_particles[slot] = obj;
+    if ( obj ) {
+      obj->m_deferred_slot = slot;
+    } else if ( --m_deferred_particles_waiting == 0 ) {
+      // only null entries are left
+      m_deferred_particles.clear();
+    }
+  }
+
+
+  void GenEvent::replace_deferred_( const GenVertex* old, GenVertex* obj ) {
+    const int slot = old->m_deferred_slot;
+    if ( slot < 0 || (std::size_t)slot >= m_deferred_vertices.size()
+         || m_deferred_vertices[slot] != old ) return;
+    m_deferred_vertices[slot] = obj;
+    if ( obj ) {
+      obj->m_deferred_slot = slot;
+    } else if ( --m_deferred_vertices_waiting == 0 ) {
+      m_deferred_vertices.clear();
+    }
+  }
+
+
+  /// test to see if we have two valid beam particles
+  bool  GenEvent::valid_beam_particles() const {
+    // first check that both are defined, then that both are in the
+    // particle "list": set_beam_particles(), set_barcode() and
+    // remove_barcode() keep track of that, so nothing is written here
+    if ( !m_beam_particle_1 || !m_beam_particle_2 ) return false;
+    return m_beam_1_in_event && m_beam_2_in_event;
   }
 
 
@@ -618,6 +1164,9 @@ namespace HepMC {
   bool  GenEvent::set_beam_particles(GenParticle* bp1, GenParticle* bp2) {
     m_beam_particle_1 = bp1;
     m_beam_particle_2 = bp2;
+    // particles of this event are in its particle "list"
+    m_beam_1_in_event = bp1 && bp1->parent_event() == this;
+    m_beam_2_in_event = bp2 && bp2->parent_event() == this;
     if( m_beam_particle_1 && m_beam_particle_2 ) return true;
     return false;
   }
@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////
+// GenEventColumns.cc
+//
+// Read-only structure-of-arrays snapshot of a GenEvent
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <functional>
+
+#include "HepMC/GenEventColumns.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  namespace {
+
+    // index of v in the vertex columns, or -1
+    // the vertex barcodes are filled in the order of GenEvent::vertices_begin(),
+    // that is -1, -2, ... when they are dense and decreasing in any case
+    int vertex_index( const std::vector<int>& barcodes,
+                      const GenVertex* v, const GenEvent& evt )
+    {
+      if ( !v || v->parent_event() != &evt ) return -1;
+      const int bc = v->barcode();
+      const std::size_t guess = (std::size_t)( -(long)bc - 1 );
+      if ( guess < barcodes.size() && barcodes[guess] == bc ) return (int)guess;
+      std::vector<int>::const_iterator i =
+        std::lower_bound( barcodes.begin(), barcodes.end(), bc, std::greater<int>() );
+      return ( i != barcodes.end() && *i == bc ) ? (int)( i - barcodes.begin() ) : -1;
+    }
+
+  } // unnamed namespace
+
+  void GenEventColumns::fill( const GenEvent& evt )
+  {
+    const std::size_t nv = evt.vertices_size();
+    m_x.resize( nv );
+    m_y.resize( nv );
+    m_z.resize( nv );
+    m_t.resize( nv );
+    m_vertex_barcode.resize( nv );
+    std::size_t j = 0;
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v, ++j ) {
+      const FourVector& pos = (*v)->position();
+      m_x[j] = pos.x();
+      m_y[j] = pos.y();
+      m_z[j] = pos.z();
+      m_t[j] = pos.t();
+      m_vertex_barcode[j] = (*v)->barcode();
+    }
+
+    const std::size_t np = evt.particles_size();
+    m_px.resize( np );
+    m_py.resize( np );
+    m_pz.resize( np );
+    m_e.resize( np );
+    m_generated_mass.resize( np );
+    m_pdg_id.resize( np );
+    m_status.resize( np );
+    m_barcode.resize( np );
+    m_production_vertex.resize( np );
+    m_end_vertex.resize( np );
+    std::size_t i = 0;
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p, ++i ) {
+      const GenParticle* part = *p;
+      const FourVector& mom = part->momentum();
+      m_px[i] = mom.px();
+      m_py[i] = mom.py();
+      m_pz[i] = mom.pz();
+      m_e[i] = mom.e();
+      m_generated_mass[i] = part->generated_mass();
+      m_pdg_id[i] = part->pdg_id();
+      m_status[i] = part->status();
+      m_barcode[i] = part->barcode();
+      m_production_vertex[i] =
+        vertex_index( m_vertex_barcode, part->production_vertex(), evt );
+      m_end_vertex[i] =
+        vertex_index( m_vertex_barcode, part->end_vertex(), evt );
+    }
+  }
+
+  void GenEventColumns::clear()
+  {
+    m_px.clear();
+    m_py.clear();
+    m_pz.clear();
+    m_e.clear();
+    m_generated_mass.clear();
+    m_pdg_id.clear();
+    m_status.clear();
+    m_barcode.clear();
+    m_production_vertex.clear();
+    m_end_vertex.clear();
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_t.clear();
+    m_vertex_barcode.clear();
+  }
+
+} // HepMC
@@ -0,0 +1,340 @@
+//////////////////////////////////////////////////////////////////////////
+// GenEventCompact.cc
+//
+// Event stored in contiguous arrays, linked by index
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+
+#include "HepMC/GenEventCompact.h"
+
+namespace HepMC {
+
+  namespace {
+
+    const WeightContainer no_weights;
+
+    // orders the side tables by particle or vertex index
+    struct FirstLess {
+      template <class T>
+      bool operator()( const T& a, int i ) const { return a.first < i; }
+    };
+
+  } // unnamed namespace
+
+  GenEventCompact::GenEventCompact()
+    : m_header(),
+      m_signal_process_vertex(-1),
+      m_beam_particles(-1,-1)
+  {}
+
+  GenEventCompact::GenEventCompact( const GenEvent& evt )
+    : m_header(),
+      m_signal_process_vertex(-1),
+      m_beam_particles(-1,-1)
+  {
+    fill( evt );
+  }
+
+  void GenEventCompact::clear()
+  {
+    m_header.clear();
+    m_particles.clear();
+    m_vertices.clear();
+    m_in_offsets.clear();
+    m_in.clear();
+    m_out_offsets.clear();
+    m_out.clear();
+    m_flow.clear();
+    m_polarization.clear();
+    m_vertex_weights.clear();
+    m_signal_process_vertex = -1;
+    m_beam_particles = std::make_pair( -1, -1 );
+  }
+
+  int GenEventCompact::particle_index( int bc ) const
+  {
+    /// the barcodes increase with the index, and are usually dense
+    if ( m_particles.empty() ) return -1;
+    const std::size_t guess = (std::size_t)( (long)bc - m_particles[0].barcode );
+    if ( guess < m_particles.size() && m_particles[guess].barcode == bc ) return (int)guess;
+    int lo = 0;
+    int hi = particles_size();
+    while ( lo < hi ) {
+      int mid = lo + ( hi - lo ) / 2;
+      if ( m_particles[mid].barcode < bc ) lo = mid + 1; else hi = mid;
+    }
+    return ( lo < particles_size() && m_particles[lo].barcode == bc ) ? lo : -1;
+  }
+
+  int GenEventCompact::vertex_index( int bc ) const
+  {
+    /// the barcodes decrease with the index, and are usually -1, -2, ...
+    if ( m_vertices.empty() ) return -1;
+    const std::size_t guess = (std::size_t)( m_vertices[0].barcode - (long)bc );
+    if ( guess < m_vertices.size() && m_vertices[guess].barcode == bc ) return (int)guess;
+    int lo = 0;
+    int hi = vertices_size();
+    while ( lo < hi ) {
+      int mid = lo + ( hi - lo ) / 2;
+      if ( m_vertices[mid].barcode > bc ) lo = mid + 1; else hi = mid;
+    }
+    return ( lo < vertices_size() && m_vertices[lo].barcode == bc ) ? lo : -1;
+  }
+
+  void GenEventCompact::fill( const GenEvent& evt )
+  {
+    clear();
+    m_header.copy_header_( evt );
+    m_header.weights() = evt.weights();
+    m_header.set_random_states( evt.random_states() );
+    //
+    // 1. the vertices and particles, in the order of the event
+    m_vertices.reserve( evt.vertices_size() );
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v ) {
+      Vertex entry;
+      entry.position = (*v)->position();
+      entry.status = (*v)->status();
+      entry.barcode = (*v)->barcode();
+      if ( !(*v)->weights().empty() ) {
+        m_vertex_weights.push_back( WeightsEntry( vertices_size(), (*v)->weights() ) );
+      }
+      m_vertices.push_back( entry );
+    }
+    m_particles.reserve( evt.particles_size() );
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p ) {
+      Particle entry;
+      entry.momentum = (*p)->momentum();
+      entry.generated_mass = (*p)->generated_mass();
+      entry.pdg_id = (*p)->pdg_id();
+      entry.status = (*p)->status();
+      entry.barcode = (*p)->barcode();
+      entry.production_vertex = -1;
+      entry.end_vertex = -1;
+      const Flow& flow = (*p)->flow();
+      for ( Flow::const_iterator f = flow.begin(); f != flow.end(); ++f ) {
+        FlowCode code;
+        code.particle = particles_size();
+        code.code_index = f->first;
+        code.code = f->second;
+        m_flow.push_back( code );
+      }
+      if ( (*p)->polarization() != Polarization(0,0) ) {
+        m_polarization.push_back( PolarizationEntry( particles_size(), (*p)->polarization() ) );
+      }
+      m_particles.push_back( entry );
+    }
+    //
+    // 2. the particles of each vertex, in the order of the vertex
+    m_in_offsets.reserve( vertices_size() + 1 );
+    m_out_offsets.reserve( vertices_size() + 1 );
+    m_in.reserve( particles_size() );
+    m_out.reserve( particles_size() );
+    m_in_offsets.push_back( 0 );
+    m_out_offsets.push_back( 0 );
+    // a particle which is attached to a vertex of the event but is not
+    // listed by the event itself (e.g. after a barcode conflict) is skipped
+    int j = 0;
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v, ++j ) {
+      for ( GenVertex::particles_in_const_iterator p = (*v)->particles_in_const_begin();
+            p != (*v)->particles_in_const_end(); ++p ) {
+        const int i = particle_index( (*p)->barcode() );
+        if ( i < 0 ) {
+          std::cerr << "GenEventCompact::fill: incoming particle " << (*p)->barcode()
+                    << " of vertex " << (*v)->barcode()
+                    << " is not in the event, skipped" << std::endl;
+          continue;
+        }
+        m_particles[i].end_vertex = j;
+        m_in.push_back( i );
+      }
+      for ( GenVertex::particles_out_const_iterator p = (*v)->particles_out_const_begin();
+            p != (*v)->particles_out_const_end(); ++p ) {
+        const int i = particle_index( (*p)->barcode() );
+        if ( i < 0 ) {
+          std::cerr << "GenEventCompact::fill: outgoing particle " << (*p)->barcode()
+                    << " of vertex " << (*v)->barcode()
+                    << " is not in the event, skipped" << std::endl;
+          continue;
+        }
+        m_particles[i].production_vertex = j;
+        m_out.push_back( i );
+      }
+      m_in_offsets.push_back( (int)m_in.size() );
+      m_out_offsets.push_back( (int)m_out.size() );
+    }
+    //
+    // 3. signal process vertex and beam particles
+    // each stays -1 unless the object is found among those stored above
+    const GenVertex* signal = evt.signal_process_vertex();
+    if ( signal && signal->parent_event() == &evt ) {
+      const int k = vertex_index( signal->barcode() );
+      if ( k >= 0 && evt.barcode_to_vertex( signal->barcode() ) == signal ) {
+        m_signal_process_vertex = k;
+      }
+    }
+    const GenParticle* beam1 = evt.beam_particles().first;
+    const GenParticle* beam2 = evt.beam_particles().second;
+    if ( beam1 && evt.barcode_to_particle( beam1->barcode() ) == beam1 ) {
+      const int i = particle_index( beam1->barcode() );
+      if ( i >= 0 ) m_beam_particles.first = i;
+    }
+    if ( beam2 && evt.barcode_to_particle( beam2->barcode() ) == beam2 ) {
+      const int i = particle_index( beam2->barcode() );
+      if ( i >= 0 ) m_beam_particles.second = i;
+    }
+  }
+
+  void GenEventCompact::fill_event( GenEvent* evt ) const
+  {
+    if ( !evt ) return;
+    evt->clear();
+    evt->copy_header_( m_header );
+    evt->weights() = m_header.weights();
+    evt->set_random_states( m_header.random_states() );
+    evt->m_vertex_barcodes.reserve( vertices_size() );
+    evt->m_particle_barcodes.reserve( particles_size() );
+    //
+    // 1. the vertices
+    std::vector<WeightsEntry>::const_iterator w = m_vertex_weights.begin();
+    for ( int j = 0; j < vertices_size(); ++j ) {
+      const Vertex& entry = m_vertices[j];
+      GenVertex* v = evt->create_vertex( entry.position, entry.status );
+      if ( w != m_vertex_weights.end() && w->first == j ) {
+        v->weights() = w->second;
+        ++w;
+      }
+      GenEvent::reserve_particles_( v, m_in_offsets[j+1] - m_in_offsets[j],
+                                    m_out_offsets[j+1] - m_out_offsets[j] );
+      evt->adopt_vertex_( v, entry.barcode );
+    }
+    //
+    // 2. the particles
+    std::vector<FlowCode>::const_iterator f = m_flow.begin();
+    std::vector<PolarizationEntry>::const_iterator pol = m_polarization.begin();
+    for ( int i = 0; i < particles_size(); ++i ) {
+      const Particle& entry = m_particles[i];
+      GenParticle* p = evt->create_particle( entry.momentum, entry.pdg_id, entry.status );
+      p->set_generated_mass( entry.generated_mass );
+      if ( f != m_flow.end() && f->particle == i ) {
+        Flow flow;
+        for ( ; f != m_flow.end() && f->particle == i; ++f ) {
+          flow.set_icode( f->code_index, f->code );
+        }
+        p->set_flow( flow );
+      }
+      if ( pol != m_polarization.end() && pol->first == i ) {
+        p->set_polarization( pol->second );
+        ++pol;
+      }
+      evt->adopt_particle_( p, entry.barcode );
+    }
+    //
+    // 3. the particles of each vertex, in their original order
+    GenEvent::vertex_iterator v = evt->vertices_begin();
+    for ( int j = 0; j < vertices_size(); ++j, ++v ) {
+      for ( int k = m_in_offsets[j]; k != m_in_offsets[j+1]; ++k ) {
+        GenEvent::attach_in_( *v, evt->m_particle_barcodes.find( m_particles[m_in[k]].barcode ) );
+      }
+      for ( int k = m_out_offsets[j]; k != m_out_offsets[j+1]; ++k ) {
+        GenEvent::attach_out_( *v, evt->m_particle_barcodes.find( m_particles[m_out[k]].barcode ) );
+      }
+    }
+    //
+    // 4. signal process vertex and beam particles
+    if ( m_signal_process_vertex != -1 ) {
+      evt->m_signal_process_vertex =
+        evt->m_vertex_barcodes.find( -m_vertices[m_signal_process_vertex].barcode );
+    }
+    evt->set_beam_particles(
+      m_beam_particles.first != -1 ?
+        evt->m_particle_barcodes.find( m_particles[m_beam_particles.first].barcode ) : 0,
+      m_beam_particles.second != -1 ?
+        evt->m_particle_barcodes.find( m_particles[m_beam_particles.second].barcode ) : 0 );
+  }
+
+  int GenEventCompact::flow( int i, int code_index ) const
+  {
+    int lo = 0;
+    int hi = (int)m_flow.size();
+    while ( lo < hi ) {
+      int mid = lo + ( hi - lo ) / 2;
+      if ( m_flow[mid].particle < i ) lo = mid + 1; else hi = mid;
+    }
+    for ( ; lo < (int)m_flow.size() && m_flow[lo].particle == i; ++lo ) {
+      if ( m_flow[lo].code_index == code_index ) return m_flow[lo].code;
+    }
+    return 0;
+  }
+
+  Polarization GenEventCompact::polarization( int i ) const
+  {
+    std::vector<PolarizationEntry>::const_iterator pol =
+      std::lower_bound( m_polarization.begin(), m_polarization.end(), i, FirstLess() );
+    return ( pol != m_polarization.end() && pol->first == i ) ? pol->second : Polarization(0,0);
+  }
+
+  const WeightContainer& GenEventCompact::vertex_weights( int j ) const
+  {
+    std::vector<WeightsEntry>::const_iterator w =
+      std::lower_bound( m_vertex_weights.begin(), m_vertex_weights.end(), j, FirstLess() );
+    return ( w != m_vertex_weights.end() && w->first == j ) ? w->second : no_weights;
+  }
+
+  GenEventCompact::IndexRange GenEventCompact::parents( int i ) const
+  {
+    const int j = m_particles[i].production_vertex;
+    return j == -1 ? IndexRange() : particles_in( j );
+  }
+
+  GenEventCompact::IndexRange GenEventCompact::children( int i ) const
+  {
+    const int j = m_particles[i].end_vertex;
+    return j == -1 ? IndexRange() : particles_out( j );
+  }
+
+  void GenEventCompact::ancestors( int i, std::vector<int>& out ) const
+  {
+    out.clear();
+    if ( m_particles[i].production_vertex != -1 ) {
+      walk( m_particles[i].production_vertex, true, out );
+    }
+  }
+
+  void GenEventCompact::descendants( int i, std::vector<int>& out ) const
+  {
+    out.clear();
+    if ( m_particles[i].end_vertex != -1 ) {
+      walk( m_particles[i].end_vertex, false, out );
+    }
+  }
+
+  void GenEventCompact::walk( int j, bool backwards, std::vector<int>& out ) const
+  {
+    /// breadth first: the particles are appended in order of distance
+    std::vector<char> seen_particle( m_particles.size(), 0 );
+    std::vector<char> seen_vertex( m_vertices.size(), 0 );
+    std::vector<int> vertices( 1, j );
+    seen_vertex[j] = 1;
+    for ( std::size_t next = 0; next != vertices.size(); ++next ) {
+      const IndexRange range = backwards ? particles_in( vertices[next] )
+                                         : particles_out( vertices[next] );
+      for ( const int* p = range.begin(); p != range.end(); ++p ) {
+        if ( seen_particle[*p] ) continue;
+        seen_particle[*p] = 1;
+        out.push_back( *p );
+        const int v = backwards ? m_particles[*p].production_vertex
+                                : m_particles[*p].end_vertex;
+        if ( v != -1 && !seen_vertex[v] ) {
+          seen_vertex[v] = 1;
+          vertices.push_back( v );
+        }
+      }
+    }
+  }
+
+} // HepMC
@@ -10,7 +10,6 @@
 #include <iostream>
 #include <ostream>
 #include <istream>
-#include <sstream>
 
 #include "HepMC/GenEvent.h"
 #include "HepMC/GenCrossSection.h"
@@ -299,14 +298,17 @@ namespace HepMC {
     }
     //
     // the end vertices of the particles are not connected until
-    //  after the event is read --- we store the values in a map until then
+    //  after the event is read --- we store the values in a list until then,
+    //  most vertices have one or two incoming particles
     TempParticleMap particle_to_end_vertex;
+    particle_to_end_vertex.reserve( 2 * num_vertices );
     //
-    // read in the vertices
+    // read in the vertices, all lines through the same string
+    std::string line;
     for ( int iii = 1; iii <= num_vertices; ++iii ) {
-      GenVertex* v = new GenVertex();
+      GenVertex* v = create_vertex();
       try {
-        detail::read_vertex(is,particle_to_end_vertex,v);
+        detail::read_vertex(is,particle_to_end_vertex,v,this,line);
       }
       catch (IO_Exception& e) {
         for( TempParticleMap::orderIterator it = particle_to_end_vertex.order_begin();
@@ -336,8 +338,7 @@ namespace HepMC {
             = particle_to_end_vertex.order_begin();
           pmap != particle_to_end_vertex.order_end(); ++pmap ) {
       GenParticle* p =  pmap->second;
-      int vtx = particle_to_end_vertex.end_vertex( p );
-      GenVertex* itsDecayVtx = barcode_to_vertex(vtx);
+      GenVertex* itsDecayVtx = barcode_to_vertex( pmap->end_vertex );
       if ( itsDecayVtx ) itsDecayVtx->add_particle_in( p );
       else {
         std::cerr << "read_io_genevent: ERROR particle points"
@@ -420,7 +421,7 @@ namespace HepMC {
     StreamInfo & info = get_stream_info(is);
     std::string line;
     std::getline(is,line);
-    std::istringstream iline(line);
+    detail::LineReader iline(line);
     std::string firstc;
     iline >> firstc;
     //
@@ -499,7 +500,7 @@ namespace HepMC {
     // now get this line and process it
     std::string line;
     std::getline(is,line);
-    std::istringstream wline(line);
+    detail::LineReader wline(line);
     std::string firstc;
     WeightContainer::size_type name_size = 0;
     wline >> firstc >> name_size;
@@ -690,12 +691,20 @@ namespace HepMC {
                                   TempParticleMap & particle_to_end_vertex,
                                   GenParticle * p )
     {
-      // get the next line
       std::string line;
+      return read_particle( is, particle_to_end_vertex, p, line );
+    }
+
+    std::istream & read_particle( std::istream & is,
+                                  TempParticleMap & particle_to_end_vertex,
+                                  GenParticle * p,
+                                  std::string & line )
+    {
+      // get the next line
       std::getline(is,line);
-      if(line.find_first_not_of("\t .+-eE1234567890",line.find_first_of("P")+1)!=std::string::npos)
+      if( !numbers_only( line, line.find_first_of('P') + 1 ) )
       {  delete p; throw IO_Exception("read_particle input stream encountered invalid data"); }
-      std::istringstream iline(line);
+      LineReader iline(line);
       std::string firstc;
       iline >> firstc;
       if( firstc != "P" ) {
@@ -797,6 +806,19 @@ namespace HepMC {
       return is;
     }
 
+    std::istream & resume_input_stream_info( std::istream & is, int io_type,
+                                             bool has_key )
+    {
+      establish_input_stream_info( is );
+      StreamInfo & info = get_stream_info(is);
+      // as if find_file_type had found the key of the listing
+      info.set_finished_first_event(true);
+      info.set_io_type( io_type );
+      info.set_has_key( has_key );
+      info.set_reading_event_header(false);
+      return is;
+    }
+
   } // detail
 
 } // HepMC
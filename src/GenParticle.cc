@@ -7,16 +7,22 @@
 #include "HepMC/GenEvent.h"
 #include "HepMC/GenVertex.h"
 #include "HepMC/GenParticle.h"
+#include "HepMC/EventArena.h"
 #include <iomanip>
 #include <limits>
+#include <algorithm>
 
 namespace HepMC {
 
+  namespace {
+    // the polarization of all particles for which none was set
+    const Polarization default_polarization( 0, 0 );
+  }
 
   GenParticle::GenParticle( void ) :
     m_momentum(0), m_pdg_id(0), m_status(0), m_flow(this),
     m_polarization(0), m_production_vertex(NULL), m_end_vertex(NULL),
-    m_barcode(0), m_generated_mass(0.)
+    m_barcode(0), m_deferred_slot(-1), m_in_arena(0), m_generated_mass(0.)
   { }
 
 
@@ -25,9 +31,10 @@ namespace HepMC {
                             const Flow& itsflow,
                             const Polarization& polar ) :
     m_momentum(momentum), m_pdg_id(pdg_id), m_status(status), m_flow(this),
-    m_polarization(polar), m_production_vertex(0), m_end_vertex(0),
-    m_barcode(0), m_generated_mass(momentum.m())
+    m_polarization(0), m_production_vertex(0), m_end_vertex(0),
+    m_barcode(0), m_deferred_slot(-1), m_in_arena(0), m_generated_mass(momentum.m())
   {
+    set_polarization(polar);
     // Establishing *this as the owner of m_flow is done above,
     // then we set it equal to the other flow pattern (subtle)
     set_flow(itsflow);
@@ -40,10 +47,13 @@ namespace HepMC {
     m_pdg_id( inparticle.pdg_id() ),
     m_status( inparticle.status() ),
     m_flow(inparticle.flow()),
-    m_polarization( inparticle.polarization() ),
+    m_polarization( inparticle.m_polarization ?
+                    new Polarization( *inparticle.m_polarization ) : 0 ),
     m_production_vertex(0),
     m_end_vertex(0),
     m_barcode(0),
+    m_deferred_slot(-1),
+    m_in_arena(0),
     m_generated_mass( inparticle.generated_mass() )
   {
     /// Shallow copy: does not copy the vertex pointers
@@ -59,6 +69,7 @@ namespace HepMC {
 
   GenParticle::~GenParticle() {
     if ( parent_event() ) parent_event()->remove_barcode(this);
+    delete m_polarization;
     //s_counter--;
   }
 
@@ -69,7 +80,7 @@ namespace HepMC {
     std::swap( m_pdg_id, other.m_pdg_id );
     std::swap( m_status, other.m_status );
     m_flow.swap( other.m_flow );
-    m_polarization.swap( other.m_polarization );
+    std::swap( m_polarization, other.m_polarization );
     std::swap( m_production_vertex, other.m_production_vertex );
     std::swap( m_end_vertex, other.m_end_vertex );
     std::swap( m_barcode, other.m_barcode );
@@ -89,6 +100,73 @@ namespace HepMC {
   }
 
 
+  const Polarization& GenParticle::polarization() const {
+    return m_polarization ? *m_polarization : default_polarization;
+  }
+
+
+  void GenParticle::set_polarization( const Polarization& pol ) {
+    /// only a polarization other than (0,0) is stored
+    if ( pol == default_polarization ) {
+      delete m_polarization;
+      m_polarization = 0;
+    } else if ( m_polarization ) {
+      *m_polarization = pol;
+    } else {
+      m_polarization = new Polarization( pol );
+    }
+  }
+
+
+  void GenParticle::take_place_of_( GenParticle& other ) {
+    /// this particle replaces other in the particle lists of its vertices,
+    /// in the barcode index and as beam particle of their event,
+    /// and takes over its barcode. other is left detached.
+    std::swap( m_production_vertex, other.m_production_vertex );
+    std::swap( m_end_vertex, other.m_end_vertex );
+    std::swap( m_barcode, other.m_barcode );
+    GenVertex* vertices[2] = { m_production_vertex, m_end_vertex };
+    for ( int i = 0; i < 2; ++i ) {
+      if ( !vertices[i] ) continue;
+      std::vector<GenParticle*>& plist = ( i == 0 )
+        ? vertices[i]->particles_out() : vertices[i]->particles_in();
+      std::replace( plist.begin(), plist.end(), &other, this );
+      GenEvent* evt = vertices[i]->parent_event();
+      if ( !evt ) continue;
+      if ( m_barcode == 0 ) {
+        evt->replace_deferred_( &other, this );
+      } else if ( evt->m_particle_barcodes.find( m_barcode ) == &other ) {
+        evt->m_particle_barcodes.set( m_barcode, this );
+      }
+      if ( evt->m_beam_particle_1 == &other ) evt->m_beam_particle_1 = this;
+      if ( evt->m_beam_particle_2 == &other ) evt->m_beam_particle_2 = this;
+    }
+  }
+
+
+  void* GenParticle::operator new( std::size_t n ) {
+    return ::operator new( n );
+  }
+
+  void* GenParticle::operator new( std::size_t n, EventArena& arena ) {
+    return arena.allocate( n );
+  }
+
+  void GenParticle::operator delete( void* p, std::size_t n ) {
+    // GenEvent marks the particles it takes from its arena, and the destructor
+    // leaves the mark alone; arena storage is reclaimed when the arena is
+    // reset.  Derived classes never come from the arena.
+    if ( !p ) return;
+    if ( n != sizeof( GenParticle ) || !static_cast<GenParticle*>( p )->m_in_arena ) {
+      ::operator delete( p );
+    }
+  }
+
+  void GenParticle::operator delete( void*, EventArena& ) {
+    // a constructor threw, the arena storage is reclaimed with the arena
+  }
+
+
   bool GenParticle::operator==( const GenParticle& a ) const {
     /// consistent with the definition of the copy constructor as a shallow
     ///  constructor,.. this operator does not test the vertex pointers.
@@ -150,6 +228,16 @@ namespace HepMC {
     return (end_vertex() != NULL) ? end_vertex()->particles_out() : std::vector<GenParticle*>();
   }
 
+  GenParticleVectorRange GenParticle::parent_range() const {
+    return m_production_vertex ? GenParticleVectorRange( m_production_vertex->particles_in() )
+                               : GenParticleVectorRange();
+  }
+
+  GenParticleVectorRange GenParticle::child_range() const {
+    return m_end_vertex ? GenParticleVectorRange( m_end_vertex->particles_out() )
+                        : GenParticleVectorRange();
+  }
+
 
   GenParticleProductionRange GenParticle::ancestors() { return GenParticleProductionRange(*this,HepMC::ancestors); }
   ConstGenParticleProductionRange GenParticle::ancestors() const { return ConstGenParticleProductionRange(*this,HepMC::ancestors); }
@@ -172,7 +260,7 @@ namespace HepMC {
     // Next bit of logic ensures the barcode maps are kept up to date
     //  in the GenEvent containers.
     if ( its_orig_event != its_new_event ) {
-      if ( its_new_event ) its_new_event->set_barcode( this, barcode() );
+      if ( its_new_event ) its_new_event->set_barcode( this, m_barcode );
       if ( its_orig_event ) its_orig_event->remove_barcode( this );
     }
   }
@@ -183,7 +271,7 @@ namespace HepMC {
     m_end_vertex = decayvertex;
     GenEvent* its_new_event = parent_event();
     if ( its_orig_event != its_new_event ) {
-      if ( its_new_event ) its_new_event->set_barcode( this, barcode() );
+      if ( its_new_event ) its_new_event->set_barcode( this, m_barcode );
       if ( its_orig_event ) its_orig_event->remove_barcode( this );
     }
   }
@@ -205,6 +293,12 @@ namespace HepMC {
   }
 
 
+  void GenParticle::assign_deferred_barcode_() const {
+    GenEvent* evt = parent_event();
+    if ( evt ) evt->assign_barcodes();
+  }
+
+
   /////////////
   // Static  //
   /////////////
@@ -7,12 +7,14 @@
 #include "HepMC/GenVertex.h"
 #include "HepMC/GenEvent.h"
 #include "HepMC/SearchVector.h"
+#include "HepMC/EventArena.h"
 #include <iomanip>       // needed for formatted output
 
 namespace HepMC {
 
   GenVertex::GenVertex( const FourVector& position, int status, const WeightContainer& weights )
-    : m_position(position), m_status(status), m_weights(weights), m_event(0), m_barcode(0)
+    : m_position(position), m_status(status), m_weights(weights), m_event(0), m_barcode(0),
+      m_depth(-1), m_deferred_slot(-1), m_in_arena(false)
   {  }
 
   GenVertex::GenVertex( const GenVertex& invertex )
@@ -22,7 +24,10 @@ namespace HepMC {
       m_status( invertex.status() ),
       m_weights( invertex.weights() ),
       m_event(0),
-      m_barcode(0)
+      m_barcode(0),
+      m_depth(-1),
+      m_deferred_slot(-1),
+      m_in_arena(false)
   {
     /// Shallow copy: does not copy the FULL list of particle pointers.
     /// Creates a copy of  - invertex
@@ -72,6 +77,10 @@ namespace HepMC {
     m_weights.swap( other.m_weights );
     std::swap( m_event, other.m_event );
     std::swap( m_barcode, other.m_barcode );
+    // the depth goes with the event which worked it out
+    std::swap( m_depth, other.m_depth );
+    if ( m_event ) m_event->invalidate_vertex_order_();
+    if ( other.m_event ) other.m_event->invalidate_vertex_order_();
   }
 
   GenVertex& GenVertex::operator=( const GenVertex& invertex ) {
@@ -95,6 +104,28 @@ namespace HepMC {
     return *this;
   }
 
+  void* GenVertex::operator new( std::size_t n ) {
+    return ::operator new( n );
+  }
+
+  void* GenVertex::operator new( std::size_t n, EventArena& arena ) {
+    return arena.allocate( n );
+  }
+
+  void GenVertex::operator delete( void* p, std::size_t n ) {
+    // GenEvent marks the vertexs it takes from its arena, and the destructor
+    // leaves the mark alone; arena storage is reclaimed when the arena is
+    // reset.  Derived classes never come from the arena.
+    if ( !p ) return;
+    if ( n != sizeof( GenVertex ) || !static_cast<GenVertex*>( p )->m_in_arena ) {
+      ::operator delete( p );
+    }
+  }
+
+  void GenVertex::operator delete( void*, EventArena& ) {
+    // a constructor threw, the arena storage is reclaimed with the arena
+  }
+
   bool GenVertex::operator==( const GenVertex& a ) const {
     /// Returns true if the positions and the particles in the lists of a
     ///  and this are identical. Does not compare barcodes.
@@ -283,6 +314,7 @@ namespace HepMC {
     }
     m_particles_in.push_back( inparticle );
     inparticle->set_end_vertex_( this );
+    if ( m_event ) m_event->invalidate_vertex_order_();
   }
 
   void GenVertex::add_particle_out( GenParticle* outparticle ) {
@@ -294,6 +326,7 @@ namespace HepMC {
     }
     m_particles_out.push_back( outparticle );
     outparticle->set_production_vertex_( this );
+    if ( m_event ) m_event->invalidate_vertex_order_();
   }
 
   GenParticle* GenVertex::remove_particle( GenParticle* particle ) {
@@ -322,12 +355,14 @@ namespace HepMC {
     /// this finds *particle in m_particles_in and removes it from that list
     if ( !particle ) return;
     m_particles_in.erase( already_in_vector( &m_particles_in, particle ) );
+    if ( m_event ) m_event->invalidate_vertex_order_();
   }
 
   void GenVertex::remove_particle_out( GenParticle* particle ) {
     /// this finds *particle in m_particles_out and removes it from that list
     if ( !particle ) return;
     m_particles_out.erase( already_in_vector( &m_particles_out, particle ) );
+    if ( m_event ) m_event->invalidate_vertex_order_();
   }
 
   void GenVertex::delete_adopted_particles() {
@@ -335,6 +370,7 @@ namespace HepMC {
     /// to be used by the vertex destructor and operator=
     //
     if ( m_particles_out.empty() && m_particles_in.empty() ) return;
+    if ( m_event ) m_event->invalidate_vertex_order_();
     // 1. delete all outgoing particles which don't have decay vertices.
     //    those that do become the responsibility of the decay vertex
     //    and have their productionvertex pointer set to NULL
@@ -389,6 +425,11 @@ namespace HepMC {
     return success;
   }
 
+  void GenVertex::assign_deferred_barcode_() const
+  {
+    if ( m_event ) m_event->assign_barcodes();
+  }
+
   void GenVertex::set_parent_event_( GenEvent* new_evt )
   {
     GenEvent* orig_evt = m_event;
@@ -398,7 +439,7 @@ namespace HepMC {
     //   in the new and old parent event needs to be modified to
     //   reflect this
     if ( orig_evt != new_evt ) {
-      if (new_evt) new_evt->set_barcode( this, barcode() );
+      if (new_evt) new_evt->set_barcode( this, m_barcode );
       if (orig_evt) orig_evt->remove_barcode( this );
       // we also need to loop over all the particles which are owned by
       //  this vertex, and remove their barcodes from the old event.
@@ -407,7 +448,7 @@ namespace HepMC {
         if ( !(*part1)->production_vertex() ) {
           if ( orig_evt ) orig_evt->remove_barcode( *part1 );
           if ( new_evt ) new_evt->set_barcode( *part1,
-                                               (*part1)->barcode() );
+                                               (*part1)->m_barcode );
         }
       }
       for ( particles_out_const_iterator
@@ -415,11 +456,19 @@ namespace HepMC {
             part2 != particles_out_const_end(); part2++ ) {
         if ( orig_evt ) orig_evt->remove_barcode( *part2 );
         if ( new_evt ) new_evt->set_barcode( *part2,
-                                             (*part2)->barcode() );
+                                             (*part2)->m_barcode );
       }
     }
   }
 
+  int GenVertex::depth() const
+  {
+    if ( !m_event ) return -1;
+    // brings m_depth up to date
+    m_event->ordered_vertices();
+    return m_depth;
+  }
+
   void GenVertex::change_parent_event_( GenEvent* new_evt )
   {
     //
@@ -430,6 +479,37 @@ namespace HepMC {
     m_event = new_evt;
   }
 
+  void GenVertex::take_place_of_( GenVertex& other )
+  {
+    //
+    // this method is for use with the move constructor
+    // the particle lists have already been moved,
+    // but the particles and the event need to point to this vertex
+    other.m_particles_in.clear();
+    other.m_particles_out.clear();
+    for ( particles_in_const_iterator part1 = particles_in_const_begin();
+          part1 != particles_in_const_end(); ++part1 ) {
+      (*part1)->m_end_vertex = this;
+    }
+    for ( particles_out_const_iterator part2 = particles_out_const_begin();
+          part2 != particles_out_const_end(); ++part2 ) {
+      (*part2)->m_production_vertex = this;
+    }
+    std::swap( m_event, other.m_event );
+    std::swap( m_barcode, other.m_barcode );
+    if ( m_event ) {
+      m_event->invalidate_vertex_order_();
+      if ( m_barcode == 0 ) {
+        m_event->replace_deferred_( &other, this );
+      } else if ( m_event->m_vertex_barcodes.find( -m_barcode ) == &other ) {
+        m_event->m_vertex_barcodes.set( -m_barcode, this );
+      }
+      if ( m_event->m_signal_process_vertex == &other ) {
+        m_event->m_signal_process_vertex = this;
+      }
+    }
+  }
+
   /////////////
   // Static  //
   /////////////
@@ -607,147 +687,110 @@ namespace HepMC {
   /////////////////////
 
   GenVertex::vertex_iterator::vertex_iterator()
-    : m_vertex(0), m_range(), m_visited_vertices(0), m_it_owns_set(0),
-      m_recursive_iterator(0)
+    : m_vertex(0), m_range(), m_stack(), m_visited(), m_visited_count(0),
+      m_visited_vertices(0)
   {}
 
   GenVertex::vertex_iterator::vertex_iterator( GenVertex& vtx_root,
                                                IteratorRange range )
-    : m_vertex(&vtx_root), m_range(range)
+    : m_vertex(0), m_range(range), m_stack(), m_visited(), m_visited_count(0),
+      m_visited_vertices(0)
   {
     // standard public constructor
     //
-    m_visited_vertices = new std::set<const GenVertex*>;
-    m_it_owns_set = 1;
-    m_visited_vertices->insert( m_vertex );
-    m_recursive_iterator = 0;
-    m_edge = m_vertex->edges_begin( m_range );
-    // advance to the first good return value
-    if ( !follow_edge_() &&
-         m_edge != m_vertex->edges_end( m_range )) ++*this;
+    start( vtx_root, range );
   }
 
   GenVertex::vertex_iterator::vertex_iterator( GenVertex& vtx_root,
                                                IteratorRange range, std::set<const HepMC::GenVertex*>& visited_vertices ) :
-    m_vertex(&vtx_root), m_range(range),
-    m_visited_vertices(&visited_vertices), m_it_owns_set(0),
-    m_recursive_iterator(0)
+    m_vertex(&vtx_root), m_range(range), m_stack(), m_visited(), m_visited_count(0),
+    m_visited_vertices(&visited_vertices)
   {
-    // This constuctor is only to be called internally by this class
-    //   for use with its recursive member pointer (m_recursive_iterator).
+    // This constuctor is only to be called internally.
     // Note: we do not need to insert m_vertex_root in the vertex - that is
-    //  the responsibility of this iterator's mother, which is normally
-    //  done just before calling this protected constructor.
-    m_edge = m_vertex->edges_begin( m_range );
-    // advance to the first good return value
-    if ( !follow_edge_() &&
-         m_edge != m_vertex->edges_end( m_range )) ++*this;
+    //  the responsibility of the caller.
+    Frame root = { m_vertex, m_vertex->edges_begin( m_range ) };
+    m_stack.push_back( root );
+    advance_();
   }
 
   GenVertex::vertex_iterator::vertex_iterator( const vertex_iterator& v_iter)
-    : m_vertex(0), m_visited_vertices(0), m_it_owns_set(0),
-      m_recursive_iterator(0)
+    : m_vertex(0), m_range(), m_stack(), m_visited(), m_visited_count(0),
+      m_visited_vertices(0)
   {
     *this = v_iter;
   }
 
-  GenVertex::vertex_iterator::~vertex_iterator() {
-    if ( m_recursive_iterator ) delete m_recursive_iterator;
-    if ( m_it_owns_set ) delete m_visited_vertices;
+  GenVertex::vertex_iterator::~vertex_iterator() {}
+
+  void GenVertex::vertex_iterator::start( GenVertex& vtx_root,
+                                          IteratorRange range ) {
+    m_vertex = &vtx_root;
+    m_range = range;
+    m_stack.clear();
+    // the table keeps its size from an earlier traversal
+    std::fill( m_visited.begin(), m_visited.end(), (const GenVertex*)0 );
+    m_visited_count = 0;
+    m_visited_vertices = 0;
+    visit_( m_vertex );
+    Frame root = { m_vertex, m_vertex->edges_begin( m_range ) };
+    m_stack.push_back( root );
+    // advance to the first good return value
+    advance_();
   }
 
   GenVertex::vertex_iterator& GenVertex::vertex_iterator::operator=(
                                                                     const vertex_iterator& v_iter )
   {
-    // Note: when copying a vertex_iterator that is NOT the owner
-    // of its set container, the pointer to the set is copied. Beware!
+    // Note: when copying a vertex_iterator that uses a set given by
+    // another iterator, the pointer to the set is copied. Beware!
     // (see copy_with_own_set() if you want a different set pointed to)
     // In practise the user never needs to worry
     // since such iterators are only intended to be used internally.
     //
-    // destruct data member pointers
-    if ( m_recursive_iterator ) delete m_recursive_iterator;
-    m_recursive_iterator = 0;
-    if ( m_it_owns_set ) delete m_visited_vertices;
-    m_visited_vertices = 0;
-    m_it_owns_set = 0;
-    // copy the target vertex_iterator to this iterator
+    if ( this == &v_iter ) return *this;
     m_vertex = v_iter.m_vertex;
     m_range = v_iter.m_range;
-    if ( v_iter.m_it_owns_set ) {
-      // i.e. this vertex will own its set if v_iter points to any
-      // vertex set regardless of whether v_iter owns the set or not!
-      m_visited_vertices =
-        new std::set<const GenVertex*>(*v_iter.m_visited_vertices);
-      m_it_owns_set = 1;
-    } else {
-      m_visited_vertices = v_iter.m_visited_vertices;
-      m_it_owns_set = 0;
-    }
-    //
-    // Note: m_vertex_root is already included in the set of
-    //  tv_iter.m_visited_vertices, we do not need to insert it.
-    //
-    m_edge = v_iter.m_edge;
-    copy_recursive_iterator_( v_iter.m_recursive_iterator );
+    m_stack = v_iter.m_stack;
+    m_visited = v_iter.m_visited;
+    m_visited_count = v_iter.m_visited_count;
+    m_visited_vertices = v_iter.m_visited_vertices;
     return *this;
   }
 
+  void GenVertex::vertex_iterator::swap( vertex_iterator& other ) {
+    std::swap( m_vertex, other.m_vertex );
+    std::swap( m_range, other.m_range );
+    m_stack.swap( other.m_stack );
+    m_visited.swap( other.m_visited );
+    std::swap( m_visited_count, other.m_visited_count );
+    std::swap( m_visited_vertices, other.m_visited_vertices );
+  }
+
   GenVertex* GenVertex::vertex_iterator::operator*(void) const {
     // de-reference operator
     //
-    // if this iterator has an iterator_node, then we return the iterator
-    // node.
-    if ( m_recursive_iterator ) return  **m_recursive_iterator;
-    //
-    // an iterator can only return its m_vertex -- any other vertex
-    //  is returned by means of a recursive iterator_node
-    //  (so this is the only place in the iterator code that a vertex
-    //   is returned!)
-    if ( m_vertex ) return m_vertex;
-    return 0;
+    // the current vertex is on top of the stack, and all the vertices
+    // it leads to have been returned already
+    if ( m_stack.empty() ) return 0;
+    return m_stack.back().vertex;
   }
 
   GenVertex::vertex_iterator& GenVertex::vertex_iterator::operator++(void) {
     // Pre-fix incremental operator
     //
-    // check for "past the end condition" denoted by m_vertex=0
-    if ( !m_vertex ) return *this;
-    // if at the last edge, move into the "past the end condition"
-    if ( m_edge == m_vertex->edges_end( m_range ) ) {
+    // check for "past the end condition" denoted by an empty stack
+    if ( m_stack.empty() ) return *this;
+    // the current vertex has been returned, go back to the one it was
+    // reached from, and follow the next edge from there
+    m_stack.pop_back();
+    if ( m_stack.empty() ) {
       m_vertex = 0;
       return *this;
     }
-    // check to see if we need to create a new recursive iterator by
-    // following the current edge only if a recursive iterator doesn't
-    // already exist. If a new recursive_iterator is created, return it.
-    if ( follow_edge_() ) {
-      return *this;
-    }
-    //
-    // if a recursive iterator already exists, increment it, and return its
-    // value (unless the recursive iterator has null root_vertex [its
-    // root vertex is set to null if it has already returned its root]
-    // - in which case we delete it)
-    // and return the vertex pointed to by the edge.
-    if ( m_recursive_iterator ) {
-      ++(*m_recursive_iterator);
-      if ( **m_recursive_iterator ) {
-        return *this;
-      } else {
-        delete m_recursive_iterator;
-        m_recursive_iterator = 0;
-      }
-    }
-    //
-    // increment to the next particle edge
-    ++m_edge;
-    // if m_edge is at the end, then we have incremented through all
-    // edges, and it is time to return m_vertex, which we accomplish
-    // by returning *this
-    if ( m_edge == m_vertex->edges_end( m_range ) ) return *this;
-    // otherwise we follow the current edge by recursively ++ing.
-    return ++(*this);
+    ++m_stack.back().edge;
+    advance_();
+    return *this;
   }
 
   GenVertex::vertex_iterator GenVertex::vertex_iterator::operator++(int) {
@@ -765,72 +808,75 @@ namespace HepMC {
     /// user to specify which set container m_visited_vertices points to.
     /// in all cases, this vertex will NOT own its set.
     //
-    // destruct data member pointers
-    if ( m_recursive_iterator ) delete m_recursive_iterator;
-    m_recursive_iterator = 0;
-    if ( m_it_owns_set ) delete m_visited_vertices;
-    m_visited_vertices = 0;
-    m_it_owns_set = false;
-    // copy the target vertex_iterator to this iterator
     m_vertex = v_iter.m_vertex;
     m_range = v_iter.m_range;
+    m_stack = v_iter.m_stack;
+    m_visited.clear();
+    m_visited_count = 0;
     m_visited_vertices = &visited_vertices;
-    m_it_owns_set = false;
-    m_edge = v_iter.m_edge;
-    copy_recursive_iterator_( v_iter.m_recursive_iterator );
   }
 
-  GenVertex* GenVertex::vertex_iterator::follow_edge_() {
-    // follows the edge pointed to by m_edge by creating a
-    // recursive iterator for it.
-    //
-    // if a m_recursive_iterator already exists,
-    // this routine has nothing to do,
-    // if there's no m_vertex, there's no point following anything,
-    // also there's no point trying to follow a null edge.
-    if ( m_recursive_iterator || !m_vertex || !*m_edge ) return 0;
+  void GenVertex::vertex_iterator::advance_() {
+    // follows the edges of the vertex on top of the stack, depth first,
+    // until it reaches a vertex which has no edge left to follow:
+    // that vertex is the next one to return.
     //
     // if the range is parents, children, or family (i.e. <= family)
-    // then only the iterator which owns the set is allowed to create
-    // recursive iterators (i.e. recursivity is only allowed to go one
-    // layer deep)
-    if ( m_range <= FAMILY && m_it_owns_set == 0 ) return 0;
-    //
-    // M.Dobbs 2001-07-16
-    // Take care of the very special-rare case where a particle might
-    // point to the same vertex for both production and end
-    if ( (*m_edge)->production_vertex() ==
-         (*m_edge)->end_vertex() ) return 0;
-    //
-    // figure out which vertex m_edge is pointing to
-    GenVertex* vtx = ( m_edge.is_parent() ?
-                       (*m_edge)->production_vertex() :
-                       (*m_edge)->end_vertex() );
-    // if the pointed to vertex doesn't exist or has already been visited,
-    // then return null
-    if ( !vtx || !(m_visited_vertices->insert(vtx).second) ) return 0;
-    // follow that edge by creating a recursive iterator
-    m_recursive_iterator = new vertex_iterator( *vtx, m_range,
-                                                *m_visited_vertices);
-    // and return the vertex pointed to by m_recursive_iterator
-    return **m_recursive_iterator;
-  }
-
-  void GenVertex::vertex_iterator::copy_recursive_iterator_(
-                                                            const vertex_iterator* recursive_v_iter ) {
-    // to properly copy the recursive iterator, we need to ensure
-    // the proper set container is transfered ... then do this
-    // operation .... you guessed it .... recursively!
-    //
-    if ( !recursive_v_iter ) return;
-    m_recursive_iterator = new vertex_iterator();
-    m_recursive_iterator->m_vertex = recursive_v_iter->m_vertex;
-    m_recursive_iterator->m_range = recursive_v_iter->m_range;
-    m_recursive_iterator->m_visited_vertices = m_visited_vertices;
-    m_recursive_iterator->m_it_owns_set = 0;
-    m_recursive_iterator->m_edge = recursive_v_iter->m_edge;
-    m_recursive_iterator->copy_recursive_iterator_(
-                                                   recursive_v_iter->m_recursive_iterator );
+    // then only the root is allowed to follow its edges, and only
+    // if it keeps track of the visited vertices itself
+    // (i.e. recursivity is only allowed to go one layer deep)
+    const bool one_layer = ( m_range <= FAMILY );
+    while ( true ) {
+      Frame& top = m_stack.back();
+      if ( one_layer && ( m_stack.size() > 1 || m_visited_vertices ) ) return;
+      GenParticle* edge = *top.edge;
+      if ( !edge ) return;
+      //
+      // M.Dobbs 2001-07-16
+      // Take care of the very special-rare case where a particle might
+      // point to the same vertex for both production and end
+      if ( edge->production_vertex() != edge->end_vertex() ) {
+        // figure out which vertex the edge is pointing to
+        GenVertex* vtx = ( top.edge.is_parent() ?
+                           edge->production_vertex() :
+                           edge->end_vertex() );
+        // follow it, unless it doesn't exist or has already been visited
+        if ( vtx && visit_( vtx ) ) {
+          Frame next = { vtx, vtx->edges_begin( m_range ) };
+          m_stack.push_back( next );
+          continue;
+        }
+      }
+      ++top.edge;
+    }
+  }
+
+  bool GenVertex::vertex_iterator::visit_( const GenVertex* vtx ) {
+    if ( m_visited_vertices ) return m_visited_vertices->insert( vtx ).second;
+    // linear probing in a table at most half full
+    if ( 2 * ( m_visited_count + 1 ) > m_visited.size() ) grow_visited_();
+    const std::size_t mask = m_visited.size() - 1;
+    std::size_t h = reinterpret_cast<std::size_t>( vtx ) >> 3;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    for ( h &= mask; m_visited[h]; h = ( h + 1 ) & mask ) {
+      if ( m_visited[h] == vtx ) return false;
+    }
+    m_visited[h] = vtx;
+    ++m_visited_count;
+    return true;
+  }
+
+  void GenVertex::vertex_iterator::grow_visited_() {
+    std::vector<const GenVertex*> old;
+    old.swap( m_visited );
+    m_visited.assign( old.empty() ? 16 : 2 * old.size(), (const GenVertex*)0 );
+    m_visited_count = 0;
+    for ( std::vector<const GenVertex*>::const_iterator v = old.begin();
+          v != old.end(); ++v ) {
+      if ( *v ) visit_( *v );
+    }
   }
 
   ///////////////////////////////
@@ -846,7 +892,7 @@ namespace HepMC {
     if ( range <= FAMILY ) {
       m_edge = GenVertex::edge_iterator( vertex_root, range );
     } else {
-      m_vertex_iterator = GenVertex::vertex_iterator(vertex_root, range);
+      m_vertex_iterator.start( vertex_root, range );
       m_edge = GenVertex::edge_iterator( **m_vertex_iterator, m_vertex_iterator.range() );
     }
     advance_to_first_();
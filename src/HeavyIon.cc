@@ -10,7 +10,6 @@
 #include <iostream>
 #include <ostream>
 #include <istream>
-#include <sstream>
 
 #include "HepMC/HeavyIon.h"
 #include "HepMC/StreamHelpers.h"
@@ -81,7 +80,7 @@ namespace HepMC {
     // get the HeavyIon line
     std::string line;
     std::getline(is,line);
-    std::istringstream iline(line);
+    detail::LineReader iline(line);
     std::string firstc;
     iline >> firstc;
     // test to be sure the next entry is of type "H"
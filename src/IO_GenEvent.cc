@@ -6,21 +6,43 @@
 
 #include "HepMC/IO_GenEvent.h"
 #include "HepMC/IO_Exception.h"
+#include "HepMC/EventIndex.h"
 #include "HepMC/GenEvent.h"
 #include "HepMC/StreamHelpers.h"
 
 namespace HepMC {
 
-  IO_GenEvent::IO_GenEvent( const std::string& filename, std::ios::openmode mode )
+  IO_GenEvent::IO_GenEvent( const std::string& filename, std::ios::openmode mode,
+                            bool map_input )
     : m_mode(mode),
-      m_file(filename.c_str(), mode),
+      m_file(),
+      m_mapped(),
+      m_mapped_stream(0),
+      m_file_buffer(),
       m_ostr(0),
       m_istr(0),
       m_iostr(0),
       m_have_file(false),
       m_error_type(IO_Exception::OK),
-      m_error_message()
+      m_error_message(),
+      m_index(0)
   {
+    const bool input_only = (m_mode&std::ios::in) && !(m_mode&std::ios::out)
+                            && !(m_mode&std::ios::app);
+    if ( map_input && input_only ) {
+      if ( m_mapped.open( filename ) ) {
+        m_mapped_stream.rdbuf( &m_mapped );
+        m_iostr = &m_mapped_stream;
+        m_istr = &m_mapped_stream;
+        detail::establish_input_stream_info(m_mapped_stream);
+        m_have_file = true;
+        return;
+      }
+      // a pipe or the like: read it in large blocks
+      m_file_buffer.resize( 1 << 20 );
+      m_file.rdbuf()->pubsetbuf( &m_file_buffer[0], m_file_buffer.size() );
+    }
+    m_file.open( filename.c_str(), mode );
     if ( (m_mode&std::ios::out && m_mode&std::ios::in) ||
          (m_mode&std::ios::app && m_mode&std::ios::in) ) {
       m_error_type = IO_Exception::InputAndOutput;
@@ -46,23 +68,27 @@ namespace HepMC {
 
 
   IO_GenEvent::IO_GenEvent( std::istream & istr )
-    : m_ostr(0),
+    : m_mapped_stream(0),
+      m_ostr(0),
       m_istr(&istr),
       m_iostr(&istr),
       m_have_file(false),
       m_error_type(IO_Exception::OK),
-      m_error_message()
+      m_error_message(),
+      m_index(0)
   {
     detail::establish_input_stream_info( istr );
   }
 
   IO_GenEvent::IO_GenEvent( std::ostream & ostr )
-    : m_ostr(&ostr),
+    : m_mapped_stream(0),
+      m_ostr(&ostr),
       m_istr(0),
       m_iostr(&ostr),
       m_have_file(false),
       m_error_type(IO_Exception::OK),
-      m_error_message()
+      m_error_message(),
+      m_index(0)
   {
     detail::establish_output_stream_info( ostr );
   }
@@ -138,6 +164,28 @@ namespace HepMC {
     return false;
   }
 
+  bool IO_GenEvent::seek_to_offset( std::streamoff offset, int io_type,
+                                    bool has_key ) {
+    if ( !m_istr ) {
+      m_error_type = IO_Exception::WrongFileType;
+      m_error_message = "HepMC::IO_GenEvent::seek_to_offset attempt to seek in output file.";
+      std::cerr << m_error_message << std::endl;
+      return false;
+    }
+    m_istr->clear();
+    if ( !m_istr->seekg( offset ) || m_istr->peek() != 'E' ) {
+      m_istr->clear();
+      return false;
+    }
+    detail::resume_input_stream_info( *m_istr, io_type, has_key );
+    return true;
+  }
+
+  bool IO_GenEvent::seek_to_event( const EventIndex& index, std::size_t n ) {
+    if ( n >= index.size() ) return false;
+    return seek_to_offset( index[n].offset, index[n].io_type, index[n].has_key );
+  }
+
   void IO_GenEvent::write_event( const GenEvent* evt ) {
     /// Writes evt to output stream. It does NOT delete the event after writing.
     //
@@ -152,6 +200,16 @@ namespace HepMC {
     //
     // write event listing key before first event only.
     write_HepMC_IO_block_begin(*m_ostr); //< what a point/object mess of API signatures...
+    if ( m_index ) {
+      EventIndex::Entry entry;
+      entry.offset = m_ostr->tellp();
+      entry.io_type = gen;
+      entry.has_key = true;
+      entry.event_number = evt->event_number();
+      entry.vertices = evt->vertices_size();
+      entry.particles = evt->particles_size();
+      m_index->add( entry );
+    }
     // explicit cast is necessary... but at least we now avoid copying the whole blimmin' event!
     GenEvent& e = const_cast<GenEvent&>(*evt);
     *m_ostr << e ;
@@ -0,0 +1,501 @@
+//////////////////////////////////////////////////////////////////////////
+// IO_GenEventParallel.cc
+//
+// input of IO_GenEvent files, with the events parsed on several threads
+//////////////////////////////////////////////////////////////////////////
+
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "HepMC/IO_GenEventParallel.h"
+#include "HepMC/GenEvent.h"
+#include "HepMC/MappedFileBuffer.h"
+#include "HepMC/StreamHelpers.h"
+#include "HepMC/StreamInfo.h"
+
+namespace HepMC {
+
+  namespace detail {
+
+    /// the events of a part of the input
+    struct EventChunk {
+      EventChunk() : text(), events(), next(0), parsed(false), last(false), error() {}
+      ~EventChunk() {
+        for ( std::size_t k = 0; k < events.size(); ++k ) delete events[k];
+      }
+
+      std::istringstream     text;    // set up by the splitting thread
+      std::vector<GenEvent*> events;  // those before next are used up
+      std::size_t            next;    // the next event to take
+      bool                   parsed;
+      bool                   last;    // there are no events after these
+      std::string            error;   // why, if the input is wrong
+    };
+
+    /// the input, the chunks in the order of the input, and the threads
+    class ParallelReader {
+    public:
+      ParallelReader( std::istream* istr, int nthreads );
+      explicit ParallelReader( const std::string& filename, int nthreads );
+      ~ParallelReader();
+
+      void use_input_units( Units::MomentumUnit mom, Units::LengthUnit len )
+      { m_momentum_unit = mom; m_length_unit = len; }
+
+      /// swap the next event into evt, false at the end of the input
+      /// or if it is wrong
+      bool next( GenEvent& evt, std::string& error );
+
+      /// what the threads do
+      void split_all();
+      void parse_all();
+
+    private:
+      void init( int nthreads );
+      void start();
+      /// the next events of the input into c, false at the end
+      bool split( EventChunk& c );
+      /// the kind of key line is: 1 event listing, 2 other listing, -1 end
+      int  key_type( const std::string& line ) const;
+      static void parse( EventChunk& c );
+      /// the next event of the parsed chunks, false if they have none yet
+      bool take( GenEvent*& evt, std::string& error );
+      void delete_spent();
+
+    private: // copying is not allowed
+      ParallelReader( const ParallelReader& );
+      ParallelReader& operator=( const ParallelReader& );
+
+    private:
+      // the input
+      MappedFileBuffer         m_mapped;
+      std::istream             m_mapped_stream;  // on m_mapped
+      std::ifstream            m_file;           // if it cannot be mapped
+      std::istream*            m_istr;
+      Units::MomentumUnit      m_momentum_unit;
+      Units::LengthUnit        m_length_unit;
+      std::vector<std::string> m_event_keys;
+      std::vector<std::string> m_other_keys;
+      std::vector<std::string> m_end_keys;
+      // used only by the splitting thread
+      std::string              m_line;
+      bool                     m_have_line;      // m_line is still to be split
+      std::string              m_key;            // of the current listing
+      bool                     m_in_listing;     // of events
+      bool                     m_in_event;
+      bool                     m_keyless;        // an "E" may start a listing
+      std::string              m_text;
+      // shared by the threads
+      int                      m_nthreads;
+      std::size_t              m_capacity;
+      std::deque<EventChunk*>  m_chunks;         // not taken yet
+      std::deque<EventChunk*>  m_unparsed;
+      std::vector<EventChunk*> m_spent;          // to be deleted
+      bool                     m_started;
+      bool                     m_split_done;
+      bool                     m_finished;
+#ifndef _WIN32
+      std::vector<pthread_t>   m_threads;
+      pthread_mutex_t          m_lock;
+      pthread_cond_t           m_room;           // for the splitting thread
+      pthread_cond_t           m_work;           // for the parsing threads
+      pthread_cond_t           m_ready;          // for next()
+#endif
+    };
+
+  } // detail
+
+  namespace {
+
+    // chunks hold whole events of at least this many bytes
+    const std::string::size_type chunk_bytes = 1 << 18;
+
+#ifndef _WIN32
+    void* split_thread( void* reader )
+    {
+      static_cast<detail::ParallelReader*>( reader )->split_all();
+      return 0;
+    }
+
+    void* parse_thread( void* reader )
+    {
+      static_cast<detail::ParallelReader*>( reader )->parse_all();
+      return 0;
+    }
+#endif
+
+  } // unnamed namespace
+
+  namespace detail {
+
+    ParallelReader::ParallelReader( std::istream* istr, int nthreads )
+      : m_mapped(),
+        m_mapped_stream(0),
+        m_file(),
+        m_istr(istr)
+    { init( nthreads ); }
+
+    ParallelReader::ParallelReader( const std::string& filename, int nthreads )
+      : m_mapped(),
+        m_mapped_stream(0),
+        m_file(),
+        m_istr(0)
+    {
+      if ( m_mapped.open( filename ) ) {
+        m_mapped_stream.rdbuf( &m_mapped );
+        m_istr = &m_mapped_stream;
+      } else {
+        m_file.open( filename.c_str() );
+        m_istr = &m_file;
+      }
+      init( nthreads );
+    }
+
+    void ParallelReader::init( int nthreads )
+    {
+      StreamInfo info;
+      m_momentum_unit = info.io_momentum_unit();
+      m_length_unit = info.io_position_unit();
+      m_event_keys.push_back( info.IO_GenEvent_Key() );
+      m_event_keys.push_back( info.IO_Ascii_Key() );
+      m_event_keys.push_back( info.IO_ExtendedAscii_Key() );
+      m_other_keys.push_back( info.IO_Ascii_PDT_Key() );
+      m_other_keys.push_back( info.IO_ExtendedAscii_PDT_Key() );
+      m_end_keys.push_back( info.IO_GenEvent_End() );
+      m_end_keys.push_back( info.IO_Ascii_End() );
+      m_end_keys.push_back( info.IO_ExtendedAscii_End() );
+      m_end_keys.push_back( info.IO_Ascii_PDT_End() );
+      m_end_keys.push_back( info.IO_ExtendedAscii_PDT_End() );
+      m_have_line = false;
+      m_in_listing = false;
+      m_in_event = false;
+      m_keyless = true;
+      m_nthreads = nthreads > 0 ? nthreads : 0;
+      m_capacity = 4 * m_nthreads + 2;
+      m_started = false;
+      m_split_done = false;
+      m_finished = false;
+#ifndef _WIN32
+      pthread_mutex_init( &m_lock, 0 );
+      pthread_cond_init( &m_room, 0 );
+      pthread_cond_init( &m_work, 0 );
+      pthread_cond_init( &m_ready, 0 );
+#endif
+    }
+
+    ParallelReader::~ParallelReader()
+    {
+#ifndef _WIN32
+      pthread_mutex_lock( &m_lock );
+      m_finished = true;
+      pthread_cond_broadcast( &m_room );
+      pthread_cond_broadcast( &m_work );
+      pthread_mutex_unlock( &m_lock );
+      for ( std::size_t t = 0; t < m_threads.size(); ++t ) pthread_join( m_threads[t], 0 );
+      pthread_cond_destroy( &m_ready );
+      pthread_cond_destroy( &m_work );
+      pthread_cond_destroy( &m_room );
+      pthread_mutex_destroy( &m_lock );
+#endif
+      for ( std::size_t k = 0; k < m_chunks.size(); ++k ) delete m_chunks[k];
+      delete_spent();
+    }
+
+    void ParallelReader::start()
+    {
+      m_started = true;
+#ifndef _WIN32
+      if ( m_nthreads == 0 ) return;
+      pthread_t thread;
+      for ( int t = 0; t < m_nthreads; ++t ) {
+        // if no more threads can be started, the others do the work
+        if ( pthread_create( &thread, 0, parse_thread, this ) != 0 ) break;
+        m_threads.push_back( thread );
+      }
+      if ( !m_threads.empty()
+           && pthread_create( &thread, 0, split_thread, this ) == 0 ) {
+        m_threads.push_back( thread );
+        return;
+      }
+      // without the threads, next() splits and parses the chunks
+      pthread_mutex_lock( &m_lock );
+      m_finished = true;
+      pthread_cond_broadcast( &m_work );
+      pthread_mutex_unlock( &m_lock );
+      for ( std::size_t t = 0; t < m_threads.size(); ++t ) pthread_join( m_threads[t], 0 );
+      m_threads.clear();
+      m_finished = false;
+#endif
+    }
+
+    int ParallelReader::key_type( const std::string& line ) const
+    {
+      for ( std::size_t k = 0; k < m_event_keys.size(); ++k ) {
+        if ( line == m_event_keys[k] ) return 1;
+      }
+      for ( std::size_t k = 0; k < m_other_keys.size(); ++k ) {
+        if ( line == m_other_keys[k] ) return 2;
+      }
+      for ( std::size_t k = 0; k < m_end_keys.size(); ++k ) {
+        if ( line == m_end_keys[k] ) return -1;
+      }
+      return 0;
+    }
+
+    bool ParallelReader::split( EventChunk& c )
+    {
+      // as GenEvent::read, an "E" line starts an event, and a listing
+      // without a key can start at the beginning or after an end key
+      m_text.clear();
+      int nevents = 0;
+      while ( m_have_line || std::getline( *m_istr, m_line ) ) {
+        m_have_line = false;
+        const char first = m_line.empty() ? '\0' : m_line[0];
+        const int key = first == 'H' ? key_type( m_line ) : 0;
+        const bool keyless = first == 'E' && !m_in_listing && m_keyless;
+        if ( ( key > 0 || keyless ) && nevents > 0 ) {
+          // a new listing starts a new chunk
+          m_have_line = true;
+          break;
+        }
+        m_keyless = false;
+        if ( key > 0 || keyless ) {
+          m_in_listing = key == 1 || keyless;
+          m_in_event = false;
+          if ( keyless ) {
+            m_key.clear();
+          } else {
+            m_key = m_line;
+            continue;
+          }
+        } else if ( key < 0 ) {
+          m_in_listing = false;
+          m_in_event = false;
+          m_keyless = true;
+          continue;
+        }
+        if ( first == 'E' && m_in_listing ) {
+          if ( nevents > 0 && m_text.size() >= chunk_bytes ) {
+            m_have_line = true;
+            break;
+          }
+          // every chunk starts with the key of its listing
+          if ( nevents == 0 && !m_key.empty() ) {
+            m_text += m_key;
+            m_text += '\n';
+          }
+          ++nevents;
+          m_in_event = true;
+        }
+        if ( m_in_event ) {
+          m_text += m_line;
+          m_text += '\n';
+        }
+      }
+      if ( nevents == 0 ) return false;
+      c.text.str( m_text );
+      establish_input_stream_info( c.text );
+      set_input_units( c.text, m_momentum_unit, m_length_unit );
+      return true;
+    }
+
+    void ParallelReader::parse( EventChunk& c )
+    {
+      // as IO_GenEvent::fill_next_event
+      while ( c.text.peek() != std::char_traits<char>::eof() ) {
+        GenEvent* evt = new GenEvent();
+        try {
+          c.text >> *evt;
+        }
+        catch ( IO_Exception& e ) {
+          c.error = e.what();
+          delete evt;
+          c.last = true;
+          return;
+        }
+        if ( !evt->is_valid() ) {
+          delete evt;
+          c.last = true;
+          return;
+        }
+        c.events.push_back( evt );
+      }
+      // the text is not needed any more
+      c.text.str( std::string() );
+    }
+
+    bool ParallelReader::take( GenEvent*& evt, std::string& error )
+    {
+      evt = 0;
+      while ( !m_chunks.empty() && m_chunks.front()->parsed ) {
+        EventChunk* c = m_chunks.front();
+        if ( c->next < c->events.size() ) {
+          evt = c->events[ c->next++ ];
+          return true;
+        }
+        if ( c->last ) {
+          error = c->error;
+          m_finished = true;
+          return true;
+        }
+        // deleting the events takes time, leave it to the parsing threads
+        m_chunks.pop_front();
+        m_spent.push_back( c );
+      }
+      return m_chunks.empty() && m_split_done;
+    }
+
+    void ParallelReader::delete_spent()
+    {
+      for ( std::size_t k = 0; k < m_spent.size(); ++k ) delete m_spent[k];
+      m_spent.clear();
+    }
+
+    bool ParallelReader::next( GenEvent& evt, std::string& error )
+    {
+      error.clear();
+      if ( m_finished ) return false;
+      if ( !m_started ) start();
+      GenEvent* taken = 0;
+#ifndef _WIN32
+      if ( !m_threads.empty() ) {
+        pthread_mutex_lock( &m_lock );
+        while ( !take( taken, error ) ) pthread_cond_wait( &m_ready, &m_lock );
+        if ( m_finished ) {
+          // the input is wrong, nothing more is needed
+          pthread_cond_broadcast( &m_work );
+        }
+        pthread_cond_signal( &m_room );
+        pthread_mutex_unlock( &m_lock );
+        // the chunk of taken is not deleted before the next call
+        if ( taken ) evt.swap( *taken );
+        return taken != 0;
+      }
+#endif
+      while ( !take( taken, error ) ) {
+        delete_spent();
+        EventChunk* c = new EventChunk();
+        if ( split( *c ) ) {
+          parse( *c );
+          c->parsed = true;
+          m_chunks.push_back( c );
+        } else {
+          delete c;
+          m_split_done = true;
+        }
+      }
+      if ( taken ) evt.swap( *taken );
+      return taken != 0;
+    }
+
+#ifndef _WIN32
+    void ParallelReader::split_all()
+    {
+      for ( ;; ) {
+        EventChunk* c = new EventChunk();
+        const bool more = split( *c );
+        pthread_mutex_lock( &m_lock );
+        while ( more && !m_finished && m_chunks.size() >= m_capacity ) {
+          pthread_cond_wait( &m_room, &m_lock );
+        }
+        if ( !more || m_finished ) {
+          delete c;
+          m_split_done = true;
+          pthread_cond_broadcast( &m_work );
+          pthread_cond_signal( &m_ready );
+          pthread_mutex_unlock( &m_lock );
+          return;
+        }
+        m_chunks.push_back( c );
+        m_unparsed.push_back( c );
+        pthread_cond_signal( &m_work );
+        pthread_mutex_unlock( &m_lock );
+      }
+    }
+
+    void ParallelReader::parse_all()
+    {
+      pthread_mutex_lock( &m_lock );
+      for ( ;; ) {
+        while ( m_unparsed.empty() && !m_split_done && !m_finished ) {
+          pthread_cond_wait( &m_work, &m_lock );
+        }
+        if ( m_unparsed.empty() || m_finished ) break;
+        EventChunk* c = m_unparsed.front();
+        m_unparsed.pop_front();
+        std::vector<EventChunk*> spent;
+        spent.swap( m_spent );
+        pthread_mutex_unlock( &m_lock );
+        for ( std::size_t k = 0; k < spent.size(); ++k ) delete spent[k];
+        parse( *c );
+        pthread_mutex_lock( &m_lock );
+        c->parsed = true;
+        if ( c == m_chunks.front() ) pthread_cond_signal( &m_ready );
+      }
+      pthread_mutex_unlock( &m_lock );
+    }
+#endif
+
+  } // detail
+
+  IO_GenEventParallel::IO_GenEventParallel( const std::string& filename, int nthreads )
+    : m_reader( new detail::ParallelReader( filename, nthreads ) ),
+      m_nthreads( nthreads > 0 ? nthreads : 0 ),
+      m_error_type(IO_Exception::OK),
+      m_error_message()
+  {}
+
+  IO_GenEventParallel::IO_GenEventParallel( std::istream& istr, int nthreads )
+    : m_reader( new detail::ParallelReader( &istr, nthreads ) ),
+      m_nthreads( nthreads > 0 ? nthreads : 0 ),
+      m_error_type(IO_Exception::OK),
+      m_error_message()
+  {}
+
+  IO_GenEventParallel::~IO_GenEventParallel()
+  { delete m_reader; }
+
+  void IO_GenEventParallel::use_input_units( Units::MomentumUnit mom,
+                                             Units::LengthUnit len )
+  { m_reader->use_input_units( mom, len ); }
+
+  void IO_GenEventParallel::print( std::ostream& ostr ) const
+  {
+    ostr << "IO_GenEventParallel: unformated ascii file input on "
+         << m_nthreads << " threads" << std::endl;
+  }
+
+  bool IO_GenEventParallel::fill_next_event( GenEvent* evt )
+  {
+    //
+    // reset error type
+    m_error_type = IO_Exception::OK;
+    //
+    // test that evt pointer is not null
+    if ( !evt ) {
+      m_error_type = IO_Exception::NullEvent;
+      m_error_message = "IO_GenEventParallel::fill_next_event error - passed null event.";
+      std::cerr << m_error_message << std::endl;
+      return false;
+    }
+    if ( m_reader->next( *evt, m_error_message ) ) return true;
+    if ( !m_error_message.empty() ) {
+      m_error_type = IO_Exception::InvalidData;
+      evt->clear();
+    }
+    return false;
+  }
+
+  void IO_GenEventParallel::write_event( const GenEvent* ) {
+    m_error_type = IO_Exception::WrongFileType;
+    m_error_message = "HepMC::IO_GenEventParallel::write_event attempt to write to input file.";
+    std::cerr << m_error_message << std::endl;
+  }
+
+} // HepMC
@@ -0,0 +1,255 @@
+//////////////////////////////////////////////////////////////////////////
+// IntegrityCheck.cc
+//
+// Consistency of the particles, vertices and indices of an event
+//////////////////////////////////////////////////////////////////////////
+
+#include "HepMC/IntegrityCheck.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  void IntegrityCheck::AddressTable::reset( std::size_t n )
+  {
+    // at most half full
+    std::size_t size = 16;
+    while ( size < 2 * n ) size *= 2;
+    m_address.assign( size, (const void*)0 );
+    m_position.resize( size );
+    m_mask = size - 1;
+  }
+
+  std::size_t IntegrityCheck::AddressTable::slot( const void* a ) const
+  {
+    // the low bits of an address are the same for all objects
+    const std::size_t h = reinterpret_cast<std::size_t>( a ) >> 4;
+    return ( h * 2654435761UL ) & m_mask;
+  }
+
+  bool IntegrityCheck::AddressTable::insert( const void* a, int i )
+  {
+    std::size_t s = slot( a );
+    while ( m_address[s] ) {
+      if ( m_address[s] == a ) return false;
+      s = ( s + 1 ) & m_mask;
+    }
+    m_address[s] = a;
+    m_position[s] = i;
+    return true;
+  }
+
+  int IntegrityCheck::AddressTable::find( const void* a ) const
+  {
+    if ( !a || m_address.empty() ) return -1;
+    for ( std::size_t s = slot( a ); m_address[s]; s = ( s + 1 ) & m_mask ) {
+      if ( m_address[s] == a ) return m_position[s];
+    }
+    return -1;
+  }
+
+  IntegrityCheck::IntegrityCheck()
+    : m_issues(),
+      m_vertices(),
+      m_particles(),
+      m_listed_in(),
+      m_listed_out(),
+      m_production(),
+      m_end(),
+      m_indegree(),
+      m_edge_offsets(),
+      m_edges(),
+      m_ready()
+  {}
+
+  IntegrityCheck::IntegrityCheck( const GenEvent& evt )
+    : m_issues(),
+      m_vertices(),
+      m_particles(),
+      m_listed_in(),
+      m_listed_out(),
+      m_production(),
+      m_end(),
+      m_indegree(),
+      m_edge_offsets(),
+      m_edges(),
+      m_ready()
+  { check( evt ); }
+
+  void IntegrityCheck::clear()
+  {
+    m_issues.clear();
+    m_vertices.reset( 0 );
+    m_particles.reset( 0 );
+  }
+
+  void IntegrityCheck::add_( Problem problem, int barcode )
+  {
+    Issue issue = { problem, barcode };
+    m_issues.push_back( issue );
+  }
+
+  bool IntegrityCheck::check( const GenEvent& evt )
+  {
+    m_issues.clear();
+    const int nv = evt.vertices_size();
+    const int np = evt.particles_size();
+    //
+    // 1. the vertices and particles of the event, and their barcodes
+    m_vertices.reset( nv );
+    int j = 0;
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v, ++j ) {
+      // a vertex found twice is in the index under a wrong barcode
+      if ( !m_vertices.insert( *v, j )
+           || evt.barcode_to_vertex( (*v)->barcode() ) != *v ) {
+        add_( vertex_barcode, (*v)->barcode() );
+      }
+      if ( (*v)->parent_event() != &evt ) add_( foreign_vertex, (*v)->barcode() );
+    }
+    m_particles.reset( np );
+    int i = 0;
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p, ++i ) {
+      if ( !m_particles.insert( *p, i )
+           || evt.barcode_to_particle( (*p)->barcode() ) != *p ) {
+        add_( particle_barcode, (*p)->barcode() );
+      }
+    }
+    //
+    // 2. the vertices of the particles
+    m_production.resize( np );
+    m_end.resize( np );
+    i = 0;
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p, ++i ) {
+      const GenVertex* prod = (*p)->production_vertex();
+      const GenVertex* end = (*p)->end_vertex();
+      m_production[i] = m_vertices.find( prod );
+      m_end[i] = m_vertices.find( end );
+      if ( !prod && !end ) add_( particle_without_vertex, (*p)->barcode() );
+      if ( prod && m_production[i] < 0 ) add_( dangling_production_vertex, (*p)->barcode() );
+      if ( end && m_end[i] < 0 ) add_( dangling_end_vertex, (*p)->barcode() );
+      if ( m_production[i] >= 0 && m_production[i] == m_end[i] ) add_( loop, (*p)->barcode() );
+    }
+    //
+    // 3. the particles of the vertices
+    m_listed_in.assign( np, 0 );
+    m_listed_out.assign( np, 0 );
+    j = 0;
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v, ++j ) {
+      for ( GenVertex::particles_in_const_iterator p = (*v)->particles_in_const_begin();
+            p != (*v)->particles_in_const_end(); ++p ) {
+        const int k = m_particles.find( *p );
+        if ( k < 0 ) add_( dangling_particle, (*v)->barcode() );
+        else if ( m_end[k] != j ) add_( wrong_end_vertex, (*v)->barcode() );
+        else ++m_listed_in[k];
+      }
+      for ( GenVertex::particles_out_const_iterator p = (*v)->particles_out_const_begin();
+            p != (*v)->particles_out_const_end(); ++p ) {
+        const int k = m_particles.find( *p );
+        if ( k < 0 ) add_( dangling_particle, (*v)->barcode() );
+        else if ( m_production[k] != j ) add_( wrong_production_vertex, (*v)->barcode() );
+        else ++m_listed_out[k];
+      }
+    }
+    i = 0;
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p, ++i ) {
+      if ( m_production[i] >= 0 && m_listed_out[i] == 0 ) {
+        add_( missing_from_production_vertex, (*p)->barcode() );
+      }
+      if ( m_end[i] >= 0 && m_listed_in[i] == 0 ) add_( missing_from_end_vertex, (*p)->barcode() );
+      if ( m_listed_out[i] > 1 || m_listed_in[i] > 1 ) add_( duplicate_particle, (*p)->barcode() );
+    }
+    //
+    // 4. the loops: the vertices which remain when those without
+    //    incoming particles are taken away, again and again
+    m_indegree.assign( nv, 0 );
+    m_edge_offsets.assign( nv + 1, 0 );
+    for ( i = 0; i < np; ++i ) {
+      if ( m_production[i] >= 0 && m_end[i] >= 0 && m_production[i] != m_end[i] ) {
+        ++m_edge_offsets[ m_production[i] + 1 ];
+        ++m_indegree[ m_end[i] ];
+      }
+    }
+    for ( j = 0; j < nv; ++j ) m_edge_offsets[j+1] += m_edge_offsets[j];
+    m_edges.resize( m_edge_offsets[nv] );
+    m_ready.assign( m_edge_offsets.begin(), m_edge_offsets.end() - 1 );
+    for ( i = 0; i < np; ++i ) {
+      if ( m_production[i] >= 0 && m_end[i] >= 0 && m_production[i] != m_end[i] ) {
+        m_edges[ m_ready[ m_production[i] ]++ ] = m_end[i];
+      }
+    }
+    m_ready.clear();
+    for ( j = 0; j < nv; ++j ) if ( m_indegree[j] == 0 ) m_ready.push_back( j );
+    for ( std::size_t r = 0; r < m_ready.size(); ++r ) {
+      const int from = m_ready[r];
+      for ( int e = m_edge_offsets[from]; e < m_edge_offsets[from+1]; ++e ) {
+        if ( --m_indegree[ m_edges[e] ] == 0 ) m_ready.push_back( m_edges[e] );
+      }
+    }
+    if ( (int)m_ready.size() < nv ) {
+      j = 0;
+      for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+            v != evt.vertices_end(); ++v, ++j ) {
+        if ( m_indegree[j] > 0 ) add_( loop, (*v)->barcode() );
+      }
+    }
+    //
+    // 5. the beam particles and the signal process vertex,
+    //    which may have been deleted
+    const std::pair<GenParticle*,GenParticle*> beams = evt.beam_particles();
+    if ( beams.first && m_particles.find( beams.first ) < 0 ) {
+      add_( beam_particle_not_in_event, 0 );
+    }
+    if ( beams.second && m_particles.find( beams.second ) < 0 ) {
+      add_( beam_particle_not_in_event, 0 );
+    }
+    if ( evt.signal_process_vertex()
+         && m_vertices.find( evt.signal_process_vertex() ) < 0 ) {
+      add_( signal_vertex_not_in_event, 0 );
+    }
+    return ok();
+  }
+
+  int IntegrityCheck::count( Problem problem ) const
+  {
+    int n = 0;
+    for ( std::size_t k = 0; k < m_issues.size(); ++k ) {
+      if ( m_issues[k].problem == problem ) ++n;
+    }
+    return n;
+  }
+
+  const char* IntegrityCheck::name( Problem problem )
+  {
+    switch ( problem ) {
+    case foreign_vertex:                 return "foreign vertex";
+    case vertex_barcode:                 return "vertex barcode";
+    case particle_barcode:               return "particle barcode";
+    case particle_without_vertex:        return "particle without vertex";
+    case dangling_production_vertex:     return "dangling production vertex";
+    case dangling_end_vertex:            return "dangling end vertex";
+    case dangling_particle:              return "dangling particle";
+    case wrong_production_vertex:        return "wrong production vertex";
+    case wrong_end_vertex:               return "wrong end vertex";
+    case missing_from_production_vertex: return "missing from production vertex";
+    case missing_from_end_vertex:        return "missing from end vertex";
+    case duplicate_particle:             return "duplicate particle";
+    case loop:                           return "loop";
+    case beam_particle_not_in_event:     return "beam particle not in event";
+    case signal_vertex_not_in_event:     return "signal vertex not in event";
+    }
+    return "unknown";
+  }
+
+  void IntegrityCheck::print( std::ostream& ostr ) const
+  {
+    for ( std::size_t k = 0; k < m_issues.size(); ++k ) {
+      ostr << "IntegrityCheck: " << name( m_issues[k].problem )
+           << " at barcode " << m_issues[k].barcode << std::endl;
+    }
+  }
+
+} // HepMC
@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////
+// MappedFileBuffer.cc
+//
+// Input stream buffer over a memory mapped file
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "HepMC/MappedFileBuffer.h"
+
+namespace HepMC {
+
+  MappedFileBuffer::MappedFileBuffer()
+    : std::streambuf(),
+      m_data(0),
+      m_size(0),
+      m_open(false)
+  {}
+
+  MappedFileBuffer::~MappedFileBuffer()
+  { close(); }
+
+  bool MappedFileBuffer::open( const std::string& filename )
+  {
+    close();
+#ifdef _WIN32
+    (void)filename;
+    return false;
+#else
+    const int fd = ::open( filename.c_str(), O_RDONLY );
+    if ( fd < 0 ) return false;
+    struct stat st;
+    // at most half the address space
+    const off_t largest = (off_t)( (std::size_t)-1 >> 1 );
+    if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_size < 0
+         || ( sizeof(off_t) > sizeof(std::size_t) && st.st_size > largest ) ) {
+      ::close( fd );
+      return false;
+    }
+    m_size = (std::size_t)st.st_size;
+    if ( m_size > 0 ) {
+      void* data = mmap( 0, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      if ( data == MAP_FAILED ) {
+        ::close( fd );
+        m_size = 0;
+        return false;
+      }
+      m_data = static_cast<char*>( data );
+#ifdef MADV_SEQUENTIAL
+      madvise( data, m_size, MADV_SEQUENTIAL );
+#endif
+    }
+    // the mapping stays valid without the descriptor
+    ::close( fd );
+    setg( m_data, m_data, m_data + m_size );
+    m_open = true;
+    return true;
+#endif
+  }
+
+  void MappedFileBuffer::close()
+  {
+#ifndef _WIN32
+    if ( m_data ) munmap( m_data, m_size );
+#endif
+    m_data = 0;
+    m_size = 0;
+    m_open = false;
+    setg( 0, 0, 0 );
+  }
+
+  MappedFileBuffer::int_type MappedFileBuffer::underflow()
+  {
+    return gptr() < egptr() ? traits_type::to_int_type( *gptr() ) : traits_type::eof();
+  }
+
+  std::streamsize MappedFileBuffer::showmanyc()
+  {
+    return gptr() < egptr() ? egptr() - gptr() : -1;
+  }
+
+  MappedFileBuffer::pos_type MappedFileBuffer::seekoff( off_type off,
+                                                        std::ios_base::seekdir dir,
+                                                        std::ios_base::openmode which )
+  {
+    if ( !m_open || !( which & std::ios_base::in ) ) return pos_type( off_type(-1) );
+    off_type start = 0;
+    if ( dir == std::ios_base::cur ) start = gptr() - eback();
+    else if ( dir == std::ios_base::end ) start = (off_type)m_size;
+    const off_type pos = start + off;
+    if ( pos < 0 || pos > (off_type)m_size ) return pos_type( off_type(-1) );
+    setg( eback(), eback() + pos, egptr() );
+    return pos_type( pos );
+  }
+
+  MappedFileBuffer::pos_type MappedFileBuffer::seekpos( pos_type pos,
+                                                        std::ios_base::openmode which )
+  {
+    return seekoff( off_type( pos ), std::ios_base::beg, which );
+  }
+
+} // HepMC
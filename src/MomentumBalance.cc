@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////
+// MomentumBalance.cc
+//
+// Four-momentum conservation at all vertices of an event
+//////////////////////////////////////////////////////////////////////////
+
+#include "HepMC/MomentumBalance.h"
+#include "HepMC/GenEvent.h"
+#include "HepMC/GenEventColumns.h"
+
+namespace HepMC {
+
+  MomentumBalance::MomentumBalance()
+    : m_dpx(),
+      m_dpy(),
+      m_dpz(),
+      m_de(),
+      m_e_in(),
+      m_in(),
+      m_out(),
+      m_violated(),
+      m_barcode(),
+      m_violations()
+  {}
+
+  MomentumBalance::MomentumBalance( const GenEvent& evt, double tolerance )
+    : m_dpx(),
+      m_dpy(),
+      m_dpz(),
+      m_de(),
+      m_e_in(),
+      m_in(),
+      m_out(),
+      m_violated(),
+      m_barcode(),
+      m_violations()
+  { fill( evt, tolerance ); }
+
+  void MomentumBalance::clear()
+  {
+    m_dpx.clear();
+    m_dpy.clear();
+    m_dpz.clear();
+    m_de.clear();
+    m_e_in.clear();
+    m_in.clear();
+    m_out.clear();
+    m_violated.clear();
+    m_barcode.clear();
+    m_violations.clear();
+  }
+
+  void MomentumBalance::reset_( int nv )
+  {
+    m_dpx.assign( nv, 0. );
+    m_dpy.assign( nv, 0. );
+    m_dpz.assign( nv, 0. );
+    m_de.assign( nv, 0. );
+    m_e_in.assign( nv, 0. );
+    m_in.assign( nv, 0 );
+    m_out.assign( nv, 0 );
+    m_violated.resize( nv );
+    m_barcode.resize( nv );
+    m_violations.clear();
+  }
+
+  void MomentumBalance::fill( const GenEvent& evt, double tolerance )
+  {
+    reset_( evt.vertices_size() );
+    int j = 0;
+    for ( GenEvent::vertex_const_iterator v = evt.vertices_begin();
+          v != evt.vertices_end(); ++v, ++j ) {
+      double dpx = 0, dpy = 0, dpz = 0, de = 0;
+      for ( GenVertex::particles_in_const_iterator p = (*v)->particles_in_const_begin();
+            p != (*v)->particles_in_const_end(); ++p ) {
+        const FourVector& mom = (*p)->momentum();
+        dpx += mom.px();
+        dpy += mom.py();
+        dpz += mom.pz();
+        de += mom.e();
+      }
+      m_e_in[j] = de;
+      for ( GenVertex::particles_out_const_iterator p = (*v)->particles_out_const_begin();
+            p != (*v)->particles_out_const_end(); ++p ) {
+        const FourVector& mom = (*p)->momentum();
+        dpx -= mom.px();
+        dpy -= mom.py();
+        dpz -= mom.pz();
+        de -= mom.e();
+      }
+      m_dpx[j] = dpx;
+      m_dpy[j] = dpy;
+      m_dpz[j] = dpz;
+      m_de[j] = de;
+      m_in[j] = (*v)->particles_in_size();
+      m_out[j] = (*v)->particles_out_size();
+      m_barcode[j] = (*v)->barcode();
+    }
+    test_( tolerance );
+  }
+
+  void MomentumBalance::fill( const GenEventColumns& columns, double tolerance )
+  {
+    const int nv = columns.vertices_size();
+    const int np = columns.particles_size();
+    reset_( nv );
+    if ( nv == 0 ) return;
+    m_barcode.assign( columns.vertex_barcode().begin(), columns.vertex_barcode().end() );
+    // the particles going in, added at their end vertex,
+    // and those coming out, subtracted at their production vertex
+    if ( np > 0 ) {
+      const double* px = &columns.px()[0];
+      const double* py = &columns.py()[0];
+      const double* pz = &columns.pz()[0];
+      const double* e = &columns.e()[0];
+      const int* end = &columns.end_vertex()[0];
+      const int* prod = &columns.production_vertex()[0];
+      for ( int i = 0; i < np; ++i ) {
+        const int j = end[i];
+        if ( j < 0 ) continue;
+        m_dpx[j] += px[i];
+        m_dpy[j] += py[i];
+        m_dpz[j] += pz[i];
+        m_de[j] += e[i];
+        m_e_in[j] += e[i];
+        ++m_in[j];
+      }
+      for ( int i = 0; i < np; ++i ) {
+        const int j = prod[i];
+        if ( j < 0 ) continue;
+        m_dpx[j] -= px[i];
+        m_dpy[j] -= py[i];
+        m_dpz[j] -= pz[i];
+        m_de[j] -= e[i];
+        ++m_out[j];
+      }
+    }
+    test_( tolerance );
+  }
+
+  void MomentumBalance::test_( double tolerance )
+  {
+    const int nv = (int)m_dpx.size();
+    if ( nv == 0 ) return;
+    // without branches, so that the vertices are tested with the
+    // vector instructions of the processor
+    const double tol2 = tolerance * tolerance;
+    const double* dpx = &m_dpx[0];
+    const double* dpy = &m_dpy[0];
+    const double* dpz = &m_dpz[0];
+    const double* de = &m_de[0];
+    const double* e_in = &m_e_in[0];
+    const int* in = &m_in[0];
+    const int* out = &m_out[0];
+    int* violated = &m_violated[0];
+    for ( int j = 0; j < nv; ++j ) {
+      const double limit = tol2 * e_in[j] * e_in[j];
+      const double p2 = dpx[j]*dpx[j] + dpy[j]*dpy[j] + dpz[j]*dpz[j];
+      violated[j] = ( in[j] > 0 ) & ( out[j] > 0 )
+        & ( ( p2 > limit ) | ( de[j]*de[j] > limit ) );
+    }
+    for ( int j = 0; j < nv; ++j ) {
+      if ( !violated[j] ) continue;
+      Violation v;
+      v.vertex = j;
+      v.barcode = m_barcode[j];
+      v.imbalance = imbalance( j );
+      m_violations.push_back( v );
+    }
+  }
+
+} // HepMC
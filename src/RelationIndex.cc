@@ -0,0 +1,334 @@
+//////////////////////////////////////////////////////////////////////////
+// RelationIndex.cc
+//
+// Ancestor and descendant relations of all particles of an event
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <climits>
+#include <limits>
+
+#include "HepMC/RelationIndex.h"
+#include "HepMC/GenEvent.h"
+
+namespace HepMC {
+
+  namespace {
+
+    const std::size_t word_bits = std::numeric_limits<unsigned long>::digits;
+
+    // events of up to this many vertices keep bits, 1 MB at most
+    const std::size_t default_bit_limit = 4096;
+
+    // number of words for the bits of the vertices before vertex j
+    std::size_t row_words( std::size_t j ) { return ( j + word_bits - 1 ) / word_bits; }
+
+  } // unnamed namespace
+
+  RelationIndex::RelationIndex()
+    : m_event(0),
+      m_vertices(),
+      m_row(),
+      m_bits(),
+      m_post(),
+      m_first_interval(),
+      m_intervals(),
+      m_bit_limit(default_bit_limit),
+      m_first_key(0),
+      m_slot(),
+      m_sparse_slot(),
+      m_by_pdg()
+  {}
+
+  RelationIndex::RelationIndex( const GenEvent& evt )
+    : m_event(0),
+      m_vertices(),
+      m_row(),
+      m_bits(),
+      m_post(),
+      m_first_interval(),
+      m_intervals(),
+      m_bit_limit(default_bit_limit),
+      m_first_key(0),
+      m_slot(),
+      m_sparse_slot(),
+      m_by_pdg()
+  { fill( evt ); }
+
+  void RelationIndex::clear()
+  {
+    m_event = 0;
+    m_vertices.clear();
+    m_row.clear();
+    m_bits.clear();
+    m_post.clear();
+    m_first_interval.clear();
+    m_intervals.clear();
+    m_first_key = 0;
+    m_slot.clear();
+    m_sparse_slot.clear();
+    m_by_pdg.clear();
+  }
+
+  void RelationIndex::fill( const GenEvent& evt )
+  {
+    clear();
+    m_event = &evt;
+    const std::vector<GenVertex*>& order = evt.ordered_vertices();
+    const std::size_t nv = order.size();
+    m_vertices.assign( order.begin(), order.end() );
+    //
+    // 1. the position of every vertex, looked up by barcode: the vertex
+    //    barcodes are usually dense, so a plain table does
+    int lo = INT_MAX;
+    int hi = INT_MIN;
+    for ( std::size_t j = 0; j < nv; ++j ) {
+      const int key = -m_vertices[j]->barcode();
+      if ( key < lo ) lo = key;
+      if ( key > hi ) hi = key;
+    }
+    if ( nv > 0 && (double)hi - lo < 2.*nv + 64 ) {
+      m_first_key = lo;
+      m_slot.assign( hi - lo + 1, -1 );
+      for ( std::size_t j = 0; j < nv; ++j ) {
+        m_slot[ -m_vertices[j]->barcode() - lo ] = (int)j;
+      }
+    } else {
+      m_sparse_slot.resize( nv );
+      for ( std::size_t j = 0; j < nv; ++j ) {
+        m_sparse_slot[j] = std::make_pair( -m_vertices[j]->barcode(), (int)j );
+      }
+      std::sort( m_sparse_slot.begin(), m_sparse_slot.end() );
+    }
+    //
+    // 2. the vertices every vertex comes from
+    if ( nv <= m_bit_limit ) {
+      fill_bits();
+    } else {
+      fill_intervals();
+    }
+    //
+    // 3. the particles by PDG id
+    m_by_pdg.reserve( evt.particles_size() );
+    for ( GenEvent::particle_const_iterator p = evt.particles_begin();
+          p != evt.particles_end(); ++p ) {
+      Entry entry;
+      entry.pdg_id = (*p)->pdg_id();
+      entry.production_vertex = vertex_index( (*p)->production_vertex() );
+      entry.end_vertex = vertex_index( (*p)->end_vertex() );
+      entry.particle = *p;
+      m_by_pdg.push_back( entry );
+    }
+    std::stable_sort( m_by_pdg.begin(), m_by_pdg.end(), ByPdgId() );
+  }
+
+  void RelationIndex::fill_bits()
+  {
+    // one bit for each vertex before vertex j in the causal order,
+    // worked out in that order
+    const std::size_t nv = m_vertices.size();
+    m_row.resize( nv + 1 );
+    m_row[0] = 0;
+    for ( std::size_t j = 0; j < nv; ++j ) m_row[j+1] = m_row[j] + row_words( j );
+    m_bits.assign( m_row[nv], 0 );
+    for ( std::size_t j = 0; j < nv; ++j ) {
+      Word* row = m_bits.empty() ? 0 : &m_bits[ m_row[j] ];
+      for ( GenVertex::particles_in_const_iterator p = m_vertices[j]->particles_in_const_begin();
+            p != m_vertices[j]->particles_in_const_end(); ++p ) {
+        const int k = vertex_index( (*p)->production_vertex() );
+        // loops are cut where they close
+        if ( k < 0 || k >= (int)j ) continue;
+        const Word bit = Word(1) << ( k % word_bits );
+        // the vertices k comes from are already here if k is
+        if ( row[ k / word_bits ] & bit ) continue;
+        row[ k / word_bits ] |= bit;
+        const Word* from = &m_bits[ m_row[k] ];
+        for ( std::size_t w = 0; w < row_words( k ); ++w ) row[w] |= from[w];
+      }
+    }
+  }
+
+  void RelationIndex::fill_intervals()
+  {
+    // the spanning tree: every vertex hangs from the first earlier vertex
+    // one of its incoming particles comes from, loops are cut as above
+    const int nv = (int)m_vertices.size();
+    std::vector<int> parent( nv, -1 );
+    std::vector<int> nchildren( nv + 1, 0 );
+    for ( int j = 0; j < nv; ++j ) {
+      for ( GenVertex::particles_in_const_iterator p = m_vertices[j]->particles_in_const_begin();
+            p != m_vertices[j]->particles_in_const_end(); ++p ) {
+        const int k = vertex_index( (*p)->production_vertex() );
+        if ( k < 0 || k >= j ) continue;
+        parent[j] = k;
+        ++nchildren[k+1];
+        break;
+      }
+    }
+    // the children of vertex k are child[ nchildren[k] ... nchildren[k+1] )
+    for ( int k = 0; k < nv; ++k ) nchildren[k+1] += nchildren[k];
+    std::vector<int> child( nv );
+    std::vector<int> next( nchildren.begin(), nchildren.end() - 1 );
+    for ( int j = 0; j < nv; ++j ) {
+      if ( parent[j] >= 0 ) child[ next[ parent[j] ]++ ] = j;
+    }
+    //
+    // post order numbers, without recursion; the numbers of the subtree
+    // of vertex j are low[j] ... m_post[j]
+    m_post.assign( nv, -1 );
+    std::vector<int> low( nv, 0 );
+    std::vector< std::pair<int,int> > stack; // vertex and next child
+    int number = 0;
+    for ( int r = 0; r < nv; ++r ) {
+      if ( parent[r] >= 0 ) continue;
+      low[r] = number;
+      stack.push_back( std::make_pair( r, nchildren[r] ) );
+      while ( !stack.empty() ) {
+        std::pair<int,int>& top = stack.back();
+        if ( top.second < nchildren[ top.first + 1 ] ) {
+          const int c = child[ top.second++ ];
+          low[c] = number;
+          stack.push_back( std::make_pair( c, nchildren[c] ) );
+        } else {
+          m_post[ top.first ] = number++;
+          stack.pop_back();
+        }
+      }
+    }
+    //
+    // the intervals of every vertex, from those of the vertices its
+    // outgoing particles go to, latest vertices first
+    std::vector<std::size_t> first( nv, 0 );
+    std::vector<std::size_t> last( nv, 0 );
+    std::vector<Interval> merged;
+    std::vector<Interval> all;
+    for ( int j = nv - 1; j >= 0; --j ) {
+      merged.clear();
+      merged.push_back( Interval( low[j], m_post[j] ) );
+      for ( GenVertex::particles_out_const_iterator p = m_vertices[j]->particles_out_const_begin();
+            p != m_vertices[j]->particles_out_const_end(); ++p ) {
+        const int c = vertex_index( (*p)->end_vertex() );
+        if ( c <= j ) continue;
+        merged.insert( merged.end(), all.begin() + first[c], all.begin() + last[c] );
+      }
+      std::sort( merged.begin(), merged.end() );
+      first[j] = all.size();
+      for ( std::vector<Interval>::const_iterator i = merged.begin(); i != merged.end(); ++i ) {
+        if ( all.size() > first[j] && i->first <= all.back().second + 1 ) {
+          if ( i->second > all.back().second ) all.back().second = i->second;
+        } else {
+          all.push_back( *i );
+        }
+      }
+      last[j] = all.size();
+    }
+    // the lists in causal order, for the lookup
+    m_first_interval.resize( nv + 1 );
+    m_first_interval[0] = 0;
+    m_intervals.reserve( all.size() );
+    for ( int j = 0; j < nv; ++j ) {
+      m_intervals.insert( m_intervals.end(), all.begin() + first[j], all.begin() + last[j] );
+      m_first_interval[j+1] = m_intervals.size();
+    }
+  }
+
+  int RelationIndex::vertex_index( const GenVertex* v ) const
+  {
+    if ( !v || !m_event || v->parent_event() != m_event ) return -1;
+    const int key = -v->barcode();
+    int j = -1;
+    if ( !m_slot.empty() ) {
+      const long k = (long)key - m_first_key;
+      if ( k >= 0 && k < (long)m_slot.size() ) j = m_slot[k];
+    } else {
+      std::vector< std::pair<int,int> >::const_iterator i =
+        std::lower_bound( m_sparse_slot.begin(), m_sparse_slot.end(),
+                          std::make_pair( key, INT_MIN ) );
+      if ( i != m_sparse_slot.end() && i->first == key ) j = i->second;
+    }
+    return ( j >= 0 && m_vertices[j] == v ) ? j : -1;
+  }
+
+  bool RelationIndex::leads_to( int k, int j ) const
+  {
+    if ( k == j ) return true;
+    if ( k > j ) return false;
+    if ( m_post.empty() ) {
+      return ( m_bits[ m_row[j] + k / word_bits ] >> ( k % word_bits ) ) & 1;
+    }
+    // the last interval of k starting at or before the number of j
+    const int number = m_post[j];
+    std::vector<Interval>::const_iterator begin = m_intervals.begin() + m_first_interval[k];
+    std::vector<Interval>::const_iterator end = m_intervals.begin() + m_first_interval[k+1];
+    std::vector<Interval>::const_iterator i =
+      std::upper_bound( begin, end, Interval( number, INT_MAX ) );
+    return i != begin && (i-1)->second >= number;
+  }
+
+  std::pair<RelationIndex::EntryIterator,RelationIndex::EntryIterator>
+  RelationIndex::with_pdg_id( int pdg_id ) const
+  {
+    return std::equal_range( m_by_pdg.begin(), m_by_pdg.end(), pdg_id, ByPdgId() );
+  }
+
+  bool RelationIndex::is_ancestor( const GenParticle* a, const GenParticle* p ) const
+  {
+    if ( !a || !p ) return false;
+    const int end = vertex_index( a->end_vertex() );
+    if ( end < 0 ) return false;
+    const int prod = vertex_index( p->production_vertex() );
+    if ( prod < 0 ) return false;
+    return leads_to( end, prod );
+  }
+
+  bool RelationIndex::is_ancestor( const GenVertex* u, const GenVertex* v ) const
+  {
+    if ( u == v ) return false;
+    const int k = vertex_index( u );
+    const int j = vertex_index( v );
+    return k >= 0 && j >= 0 && leads_to( k, j );
+  }
+
+  bool RelationIndex::has_ancestor( const GenParticle* p, int pdg_id ) const
+  {
+    if ( !p ) return false;
+    const int prod = vertex_index( p->production_vertex() );
+    if ( prod < 0 ) return false;
+    std::pair<EntryIterator,EntryIterator> r = with_pdg_id( pdg_id );
+    for ( EntryIterator i = r.first; i != r.second; ++i ) {
+      if ( i->end_vertex >= 0 && leads_to( i->end_vertex, prod ) ) return true;
+    }
+    return false;
+  }
+
+  void RelationIndex::ancestors( const GenParticle* p, int pdg_id,
+                                 std::vector<GenParticle*>& out ) const
+  {
+    out.clear();
+    if ( !p ) return;
+    const int prod = vertex_index( p->production_vertex() );
+    if ( prod < 0 ) return;
+    std::pair<EntryIterator,EntryIterator> r = with_pdg_id( pdg_id );
+    for ( EntryIterator i = r.first; i != r.second; ++i ) {
+      if ( i->end_vertex >= 0 && leads_to( i->end_vertex, prod ) ) {
+        out.push_back( i->particle );
+      }
+    }
+  }
+
+  void RelationIndex::descendants( const GenParticle* p, int pdg_id,
+                                   std::vector<GenParticle*>& out ) const
+  {
+    out.clear();
+    if ( !p ) return;
+    const int end = vertex_index( p->end_vertex() );
+    if ( end < 0 ) return;
+    std::pair<EntryIterator,EntryIterator> r = with_pdg_id( pdg_id );
+    for ( EntryIterator i = r.first; i != r.second; ++i ) {
+      if ( i->production_vertex >= 0 && leads_to( end, i->production_vertex ) ) {
+        out.push_back( i->particle );
+      }
+    }
+  }
+
+} // HepMC
@@ -7,9 +7,15 @@
 //
 // ----------------------------------------------------------------------
 
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <locale>
 #include <ostream>
 #include <istream>
 #include <sstream>
+#include <stdlib.h>
 
 #include "HepMC/GenVertex.h"
 #include "HepMC/GenParticle.h"
@@ -22,7 +28,18 @@ namespace HepMC {
 
     std::istream & read_vertex( std::istream & is,
                                 TempParticleMap & particle_to_end_vertex,
-                                GenVertex * v )
+                                GenVertex * v,
+                                GenEvent * evt )
+    {
+      std::string line;
+      return read_vertex( is, particle_to_end_vertex, v, evt, line );
+    }
+
+    std::istream & read_vertex( std::istream & is,
+                                TempParticleMap & particle_to_end_vertex,
+                                GenVertex * v,
+                                GenEvent * evt,
+                                std::string & line )
     {
       //
       // make sure the stream is valid
@@ -33,11 +50,10 @@ namespace HepMC {
       }
       //
       // get the vertex line
-      std::string line;
       std::getline(is,line);
-      if(line.find_first_not_of("\t .+-eE1234567890",line.find_first_of("V")+1)!=std::string::npos)  
+      if( !numbers_only( line, line.find_first_of('V') + 1 ) )
       {  throw IO_Exception("read_vertex input stream encountered invalid data"); }
-      std::istringstream iline(line);
+      LineReader iline(line);
       std::string firstc;
       iline >> firstc;
       //
@@ -85,19 +101,317 @@ namespace HepMC {
       // read and create the associated particles. outgoing particles are
       //  added to their production vertices immediately, while incoming
       //  particles are added to a map and handled later.
+      //  The vertex line is no longer needed, so they reuse its string.
       for ( int i2 = 1; i2 <= num_orphans_in; ++i2 ) {
-        GenParticle* p1 = new GenParticle( );
-        detail::read_particle(is,particle_to_end_vertex,p1);
+        GenParticle* p1 = evt ? evt->create_particle() : new GenParticle( );
+        detail::read_particle(is,particle_to_end_vertex,p1,line);
       }
       for ( int i3 = 1; i3 <= num_particles_out; ++i3 ) {
-        GenParticle* p2 = new GenParticle( );
-        detail::read_particle(is,particle_to_end_vertex,p2);
+        GenParticle* p2 = evt ? evt->create_particle() : new GenParticle( );
+        detail::read_particle(is,particle_to_end_vertex,p2,line);
         v->add_particle_out( p2 );
       }
 
       return is;
     }
 
+    namespace {
+
+      // the blanks of std::isspace in the "C" locale
+      inline bool is_blank( char c ) { return c == ' ' || ( c >= '\t' && c <= '\r' ); }
+
+      inline bool is_digit( char c ) { return c >= '0' && c <= '9'; }
+
+      // the characters which read_vertex and read_particle accept
+      inline bool number_character( char c ) {
+        switch ( c ) {
+        case '\t': case ' ': case '.': case '+': case '-': case 'e': case 'E':
+          return true;
+        default:
+          return is_digit( c );
+        }
+      }
+
+      // a signed integer of at most max from its magnitude, as a stream
+      // gives it: the nearest limit if it does not fit
+      bool signed_value( unsigned long magnitude, bool negative, long max, long & value )
+      {
+        const unsigned long limit = (unsigned long)max + ( negative ? 1UL : 0UL );
+        if ( magnitude > limit ) {
+          value = negative ? -max - 1 : max;
+          return false;
+        }
+        if ( !negative ) value = (long)magnitude;
+        else if ( magnitude == limit ) value = -max - 1;
+        else value = -(long)magnitude;
+        return true;
+      }
+
+      // true if long double arithmetic keeps 64 bits or more, so that
+      // an unsigned long and the powers of ten up to 10^27 are exact
+      bool extended_precision()
+      {
+        if ( std::numeric_limits<long double>::digits < 64 ) return false;
+        // the precision control of an x87 unit may have been lowered
+        volatile long double x = 1;
+        x += 1.L / 1024 / 1024 / 1024 / 1024 / 1024 / 1024 / 8;  // 2^-63
+        x -= 1;
+        return x != 0;
+      }
+      const bool has_extended_precision = extended_precision();
+
+      // the decimal number [begin,end) to double without the C library:
+      // its digits make an exact integer, and one multiplication or
+      // division by an exact power of ten rounds it once, to 64 bits or
+      // more. Rounding that to double gives the correctly rounded value
+      // unless it lies half way between two doubles. False if the number
+      // is not in the range where this holds.
+      bool fast_convert( const char* begin, const char* end, double & value )
+      {
+        static const long double power[] = {
+          1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L,
+          1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+          1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L };
+        if ( !has_extended_precision ) return false;
+        const char* c = begin;
+        const bool negative = ( *c == '-' );
+        if ( *c == '+' || *c == '-' ) ++c;
+        // the digits, as long as they fit into an unsigned long
+        static const int max_digits = ( ULONG_MAX / 1000000000UL / 1000000000UL >= 10 ) ? 19 : 9;
+        unsigned long mantissa = 0;
+        int ndigits = 0;   // counted from the first non-zero digit
+        int exponent = 0;
+        for ( ; c != end && is_digit( *c ); ++c ) {
+          mantissa = mantissa * 10 + ( *c - '0' );
+          if ( mantissa ) ++ndigits;
+        }
+        if ( c != end && *c == '.' ) {
+          for ( ++c; c != end && is_digit( *c ); ++c ) {
+            mantissa = mantissa * 10 + ( *c - '0' );
+            if ( mantissa ) ++ndigits;
+            --exponent;
+          }
+        }
+        if ( ndigits > max_digits ) return false;
+        if ( c != end ) {
+          ++c;  // e or E
+          const bool negative_exponent = ( *c == '-' );
+          if ( *c == '+' || *c == '-' ) ++c;
+          int e = 0;
+          for ( ; c != end && e < 10000; ++c ) e = e * 10 + ( *c - '0' );
+          if ( c != end ) return false;
+          exponent += negative_exponent ? -e : e;
+        }
+        long double x = mantissa;
+        if ( mantissa != 0 ) {
+          if ( exponent > 27 || exponent < -27 ) return false;
+          if ( exponent > 0 ) x *= power[exponent];
+          else if ( exponent < 0 ) x /= power[-exponent];
+        }
+        const double d = (double)x;
+        // outside the normal numbers the rounding to double is different
+        if ( x != 0 && ( d > std::numeric_limits<double>::max()
+                         || d < std::numeric_limits<double>::min() ) ) return false;
+        // half way between d and its neighbour: then x + ( x - d ) is that
+        // neighbour, and a double. The store keeps -ffast-math, with which
+        // the library may be built, from taking the conversion back.
+        const long double r = x - d;
+        if ( r != 0 ) {
+          const long double other = x + r;
+          volatile double narrow = (double)other;
+          if ( (long double)narrow == other ) return false;
+        }
+        value = negative ? -d : d;
+        return true;
+      }
+
+      inline double c_convert( const char* s, char** stop, double ) { return strtod( s, stop ); }
+      inline float c_convert( const char* s, char** stop, float ) { return strtof( s, stop ); }
+
+      // floats are left to the C library
+      inline bool fast_convert( const char*, const char*, float & ) { return false; }
+
+      // convert a number which LineReader::scan_float_ has found, with the
+      // conversion of the "C" locale which a stream uses
+      template <class T>
+      bool convert_float( const char* begin, const char* end, T & value )
+      {
+        if ( fast_convert( begin, end, value ) ) return true;
+        char buffer[64];
+        std::string longer;
+        const std::size_t n = end - begin;
+        const char* s = buffer;
+        if ( n < sizeof(buffer) ) {
+          std::memcpy( buffer, begin, n );
+          buffer[n] = 0;
+        } else {
+          longer.assign( begin, end );
+          s = longer.c_str();
+        }
+        char* stop = 0;
+        errno = 0;
+        value = c_convert( s, &stop, T() );
+        if ( stop != s + n ) {
+          // the decimal point of the C library is not '.'
+          std::istringstream in( std::string( begin, end ) );
+          in.imbue( std::locale::classic() );
+          in >> value;
+          return !in.fail();
+        }
+        // as for a stream, a number out of range gives the largest one;
+        // not compared with infinity, which -ffast-math does not know
+        if ( errno == ERANGE && ( value > 1 || value < -1 ) ) {
+          value = ( value > 0 ) ? std::numeric_limits<T>::max() : -std::numeric_limits<T>::max();
+          return false;
+        }
+        return true;
+      }
+
+    } // unnamed namespace
+
+    bool numbers_only( const std::string & line, std::string::size_type pos )
+    {
+      for ( const char* c = line.data() + pos; c < line.data() + line.size(); ++c ) {
+        if ( !number_character( *c ) ) return false;
+      }
+      return true;
+    }
+
+    bool LineReader::start_()
+    {
+      if ( m_fail ) return false;
+      while ( m_pos != m_end && is_blank( *m_pos ) ) ++m_pos;
+      if ( m_pos == m_end ) {
+        m_eof = true;
+        m_fail = true;
+        return false;
+      }
+      return true;
+    }
+
+    bool LineReader::read_integer_( unsigned long & magnitude, bool & negative )
+    {
+      magnitude = 0;
+      negative = false;
+      if ( !start_() ) return false;
+      if ( *m_pos == '+' || *m_pos == '-' ) {
+        negative = ( *m_pos == '-' );
+        ++m_pos;
+      }
+      const char* digits = m_pos;
+      bool overflow = false;
+      for ( ; m_pos != m_end && is_digit( *m_pos ); ++m_pos ) {
+        const unsigned long d = *m_pos - '0';
+        if ( magnitude > ( ULONG_MAX - d ) / 10 ) overflow = true;
+        magnitude = magnitude * 10 + d;
+      }
+      if ( m_pos == m_end ) m_eof = true;
+      if ( m_pos == digits || overflow ) {
+        m_fail = true;
+        if ( overflow ) magnitude = ULONG_MAX;
+        return false;
+      }
+      return true;
+    }
+
+    bool LineReader::scan_float_()
+    {
+      if ( !start_() ) return false;
+      m_begin = m_pos;
+      if ( *m_pos == '+' || *m_pos == '-' ) ++m_pos;
+      int ndigits = 0;
+      for ( ; m_pos != m_end && is_digit( *m_pos ); ++m_pos ) ++ndigits;
+      if ( m_pos != m_end && *m_pos == '.' ) {
+        for ( ++m_pos; m_pos != m_end && is_digit( *m_pos ); ++m_pos ) ++ndigits;
+      }
+      bool ok = ndigits > 0;
+      if ( ok && m_pos != m_end && ( *m_pos == 'e' || *m_pos == 'E' ) ) {
+        ++m_pos;
+        if ( m_pos != m_end && ( *m_pos == '+' || *m_pos == '-' ) ) ++m_pos;
+        const char* exponent = m_pos;
+        while ( m_pos != m_end && is_digit( *m_pos ) ) ++m_pos;
+        ok = ( m_pos != exponent );
+      }
+      if ( m_pos == m_end ) m_eof = true;
+      if ( !ok ) m_fail = true;
+      return ok;
+    }
+
+    LineReader & LineReader::operator >> ( std::string & word )
+    {
+      if ( !start_() ) return *this;
+      const char* begin = m_pos;
+      while ( m_pos != m_end && !is_blank( *m_pos ) ) ++m_pos;
+      if ( m_pos == m_end ) m_eof = true;
+      word.assign( begin, m_pos );
+      return *this;
+    }
+
+    LineReader & LineReader::operator >> ( long & i )
+    {
+      if ( m_fail ) return *this;
+      unsigned long magnitude;
+      bool negative;
+      read_integer_( magnitude, negative );
+      if ( !signed_value( magnitude, negative, LONG_MAX, i ) ) m_fail = true;
+      return *this;
+    }
+
+    LineReader & LineReader::operator >> ( int & i )
+    {
+      if ( m_fail ) return *this;
+      unsigned long magnitude;
+      bool negative;
+      read_integer_( magnitude, negative );
+      long l = 0;
+      if ( !signed_value( magnitude, negative, INT_MAX, l ) ) m_fail = true;
+      i = (int)l;
+      return *this;
+    }
+
+    LineReader & LineReader::operator >> ( unsigned long & i )
+    {
+      if ( m_fail ) return *this;
+      unsigned long magnitude;
+      bool negative;
+      const bool ok = read_integer_( magnitude, negative );
+      // as for a stream, a minus sign is taken modulo 2^n
+      i = ( ok && negative ) ? -magnitude : magnitude;
+      return *this;
+    }
+
+    LineReader & LineReader::operator >> ( unsigned int & i )
+    {
+      if ( m_fail ) return *this;
+      unsigned long magnitude;
+      bool negative;
+      const bool ok = read_integer_( magnitude, negative );
+      if ( magnitude > UINT_MAX ) {
+        m_fail = true;
+        i = UINT_MAX;
+      } else {
+        i = (unsigned int)magnitude;
+        if ( ok && negative ) i = -i;
+      }
+      return *this;
+    }
+
+    LineReader & LineReader::operator >> ( double & d )
+    {
+      if ( m_fail ) return *this;
+      if ( !scan_float_() ) d = 0;
+      else if ( !convert_float( m_begin, m_pos, d ) ) m_fail = true;
+      return *this;
+    }
+
+    LineReader & LineReader::operator >> ( float & f )
+    {
+      if ( m_fail ) return *this;
+      if ( !scan_float_() ) f = 0;
+      else if ( !convert_float( m_begin, m_pos, f ) ) m_fail = true;
+      return *this;
+    }
+
     std::istream & find_event_end( std::istream & is ) {
       // since there is no end of event flag,
       // read one line at time until we find the next event
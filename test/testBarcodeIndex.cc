@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////
+// testBarcodeIndex.cc
+//
+// barcode lookup and iteration order of the GenEvent barcode indices
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <vector>
+
+#include "HepMC/BarcodeIndex.h"
+#include "HepMC/GenEvent.h"
+
+typedef HepMC::detail::BarcodeIndex<int> Index;
+
+// keys in iteration order
+std::vector<int> keys( const Index& index )
+{
+  std::vector<int> out;
+  for ( Index::const_iterator i = index.begin(); i != index.end(); ++i ) {
+    out.push_back( i.key() );
+  }
+  return out;
+}
+
+void test_index()
+{
+  int obj[10];
+  Index index;
+  assert( index.empty() );
+  assert( index.max_key() == 0 );
+  assert( index.begin() == index.end() );
+  // dense keys, a far outlier, and negative keys
+  index.set( 3, &obj[3] );
+  index.set( 1, &obj[1] );
+  index.set( 2, &obj[2] );
+  index.set( 100000, &obj[4] );
+  index.set( -5, &obj[5] );
+  assert( index.size() == 5 );
+  assert( index.find(1) == &obj[1] );
+  assert( index.find(100000) == &obj[4] );
+  assert( index.find(-5) == &obj[5] );
+  assert( index.find(4) == 0 );
+  assert( index.max_key() == 100000 );
+  std::vector<int> k = keys( index );
+  assert( k.size() == 5 );
+  assert( k[0] == -5 && k[1] == 1 && k[2] == 2 && k[3] == 3 && k[4] == 100000 );
+  // overwriting does not add an entry
+  index.set( 2, &obj[6] );
+  assert( index.size() == 5 );
+  assert( index.find(2) == &obj[6] );
+  // erase only if the entry refers to the given object
+  index.erase( 2, &obj[2] );
+  assert( index.find(2) == &obj[6] );
+  index.erase( 2, &obj[6] );
+  assert( index.find(2) == 0 );
+  assert( index.size() == 4 );
+  // erasing does not invalidate iterators to other entries
+  index.set( 4, &obj[7] );
+  Index::const_iterator i = index.begin();
+  ++i;
+  ++i;
+  assert( i.key() == 3 );
+  index.erase( 4 );
+  index.erase( 1 );
+  ++i;
+  assert( i.key() == 100000 );
+  index.erase( 100000 );
+  assert( index.max_key() == 3 );
+  // repeatedly removing the first entry
+  index.clear();
+  for ( int n = 1; n <= 1000; ++n ) index.set( n, &obj[0] );
+  assert( index.size() == 1000 );
+  int expected = 1;
+  while ( !index.empty() ) {
+    assert( index.begin().key() == expected++ );
+    index.erase( index.begin().key() );
+  }
+  assert( expected == 1001 );
+  assert( index.begin() == index.end() );
+  // the first entry is kept up to date by erasing and setting
+  for ( int n = 1; n <= 6; ++n ) index.set( n, &obj[0] );
+  index.erase( 2 );
+  index.erase( 1 );
+  assert( index.begin().key() == 3 );
+  index.set( 2, &obj[1] );
+  assert( index.begin().key() == 2 );
+  index.erase( 2 );
+  index.erase( 3 );
+  index.erase( 4 );
+  assert( index.begin().key() == 5 );
+  assert( keys( index ).size() == 2 );
+}
+
+void test_event()
+{
+  HepMC::GenEvent evt;
+  HepMC::GenVertex* v1 = new HepMC::GenVertex();
+  evt.add_vertex( v1 );
+  HepMC::GenVertex* v2 = new HepMC::GenVertex();
+  evt.add_vertex( v2 );
+  assert( v1->barcode() == -1 && v2->barcode() == -2 );
+  assert( evt.barcode_to_vertex(-2) == v2 );
+  assert( evt.barcode_to_vertex(2) == 0 );
+  // particles from HEPEVT-like sources get their index as barcode
+  for ( int n = 1; n <= 5; ++n ) {
+    HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,n,n), 22, 1 );
+    v1->add_particle_out( p );
+    assert( p->barcode() == 10001 );
+    assert( p->suggest_barcode( n ) );
+  }
+  HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 );
+  v2->add_particle_out( p );
+  assert( p->barcode() == 10001 );
+  // a barcode that is in use is rejected and a new one assigned
+  assert( !p->suggest_barcode( 3 ) );
+  assert( p->barcode() == 10001 );
+  assert( p->suggest_barcode( 20000 ) );
+  HepMC::GenParticle* p2 = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 );
+  v2->add_particle_out( p2 );
+  assert( p2->barcode() == 20001 );
+  assert( evt.barcode_to_particle(3)->momentum().pz() == 3 );
+  assert( evt.particles_size() == 7 );
+  // iteration is in order of increasing |barcode|
+  int last = 0;
+  for ( HepMC::GenEvent::particle_const_iterator i = evt.particles_begin();
+        i != evt.particles_end(); ++i ) {
+    assert( (*i)->barcode() > last );
+    last = (*i)->barcode();
+  }
+  assert( v2->suggest_barcode( -7 ) );
+  assert( evt.barcode_to_vertex(-2) == 0 );
+  HepMC::GenEvent::vertex_const_iterator v = evt.vertices_begin();
+  assert( *v == v1 );
+  assert( *++v == v2 );
+  assert( ++v == evt.vertices_end() );
+  HepMC::GenVertex* v3 = new HepMC::GenVertex();
+  evt.add_vertex( v3 );
+  assert( v3->barcode() == -8 );
+  // removing a vertex removes its barcode
+  delete v2;
+  assert( evt.barcode_to_vertex(-7) == 0 );
+  assert( evt.vertices_size() == 2 );
+  assert( evt.particles_size() == 5 );
+  assert( evt.barcode_to_particle(20000) == 0 );
+}
+
+int main()
+{
+  test_index();
+  test_event();
+  return 0;
+}
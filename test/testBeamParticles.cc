@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////
+// testBeamParticles.cc
+//
+// beam particles and signal process vertex while the event changes
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+
+#include "HepMC/GenEvent.h"
+
+// two beams colliding at the signal vertex, which decays further
+struct Collision {
+  HepMC::GenParticle* beam1;
+  HepMC::GenParticle* beam2;
+  HepMC::GenVertex*   signal;
+  HepMC::GenVertex*   decay;
+};
+
+Collision build( HepMC::GenEvent& evt, bool beams_first )
+{
+  Collision c;
+  c.beam1 = new HepMC::GenParticle( HepMC::FourVector(0,0, 7000,7000), 2212, 4 );
+  c.beam2 = new HepMC::GenParticle( HepMC::FourVector(0,0,-7000,7000), 2212, 4 );
+  // set before the particles belong to the event
+  if ( beams_first ) evt.set_beam_particles( c.beam1, c.beam2 );
+  c.signal = new HepMC::GenVertex();
+  c.signal->add_particle_in( c.beam1 );
+  c.signal->add_particle_in( c.beam2 );
+  HepMC::GenParticle* z = new HepMC::GenParticle( HepMC::FourVector(0,0,0,91.2), 23, 2 );
+  c.signal->add_particle_out( z );
+  c.decay = new HepMC::GenVertex();
+  c.decay->add_particle_in( z );
+  c.decay->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,0, 45.6,45.6), 11, 1 ) );
+  c.decay->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,0,-45.6,45.6), -11, 1 ) );
+  evt.add_vertex( c.signal );
+  evt.add_vertex( c.decay );
+  evt.set_signal_process_vertex( c.signal );
+  if ( !beams_first ) evt.set_beam_particles( c.beam1, c.beam2 );
+  return c;
+}
+
+int main()
+{
+  // beams set before or after they come into the event, which gives
+  // them their barcodes at once or later
+  for ( int mode = 0; mode < 4; ++mode ) {
+    const bool beams_first = ( mode % 2 ) != 0;
+    HepMC::GenEvent evt;
+    evt.defer_barcodes( mode >= 2 );
+    Collision c = build( evt, beams_first );
+    assert( evt.valid_beam_particles() );
+    assert( evt.beams().size() == 2 );
+    assert( evt.signal_process_vertex() == c.signal );
+    //
+    // copies and swaps keep them
+    HepMC::GenEvent copy( evt );
+    assert( copy.valid_beam_particles() );
+    assert( copy.beam_particles().first != c.beam1 );
+    assert( copy.signal_process_vertex() &&
+            copy.signal_process_vertex()->barcode() == c.signal->barcode() );
+    HepMC::GenEvent other;
+    other.swap( copy );
+    assert( other.valid_beam_particles() );
+    assert( !copy.valid_beam_particles() );
+    //
+    // a beam particle taken off its vertex leaves the event
+    c.signal->remove_particle( c.beam1 );
+    assert( !evt.valid_beam_particles() );
+    assert( evt.beams().empty() );
+    // and comes back
+    c.signal->add_particle_in( c.beam1 );
+    assert( evt.valid_beam_particles() );
+    // a deleted beam particle is not looked at
+    delete c.signal->remove_particle( c.beam2 );
+    assert( !evt.valid_beam_particles() );
+    evt.set_beam_particles( c.beam1, 0 );
+    assert( !evt.valid_beam_particles() );
+    //
+    // the signal vertex is forgotten when it leaves the event
+    evt.remove_vertex( c.signal );
+    assert( evt.signal_process_vertex() == 0 );
+    // also with the beam particle
+    assert( !evt.valid_beam_particles() );
+    evt.set_signal_process_vertex( c.signal );
+    assert( evt.signal_process_vertex() == c.signal );
+    // when it is deleted
+    delete c.signal;
+    assert( evt.signal_process_vertex() == 0 );
+    // and when it is moved to another event
+    evt.set_signal_process_vertex( c.decay );
+    other.add_vertex( c.decay );
+    assert( evt.signal_process_vertex() == 0 );
+    assert( evt.vertices_empty() );
+    // clear() forgets everything
+    other.clear();
+    assert( !other.valid_beam_particles() );
+    assert( other.signal_process_vertex() == 0 );
+  }
+  return 0;
+}
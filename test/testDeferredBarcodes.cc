@@ -0,0 +1,220 @@
+//////////////////////////////////////////////////////////////////////////
+// testDeferredBarcodes.cc
+//
+// events built with deferred barcodes must end up like events built
+// with immediate barcodes
+// run with valgrind or some other leak checker
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HepMC/GenEvent.h"
+
+std::string as_text( HepMC::GenEvent& evt )
+{
+  std::ostringstream os;
+  evt.write( os );
+  return os.str();
+}
+
+// a beam particle decaying in a chain of n vertices with two products each
+void build( HepMC::GenEvent& evt, int n )
+{
+  HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,n,n), 2212, 4 );
+  for ( int k = 0; k < n; ++k ) {
+    HepMC::GenVertex* v = new HepMC::GenVertex( HepMC::FourVector(0,0,k,k) );
+    evt.add_vertex( v );
+    v->add_particle_in( p );
+    v->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,1,k,k), 22, 1 ) );
+    p = new HepMC::GenParticle( HepMC::FourVector(0,0,k,k), 2212, 2 );
+    v->add_particle_out( p );
+  }
+}
+
+void test_same_as_immediate()
+{
+  HepMC::GenEvent immediate;
+  build( immediate, 100 );
+  HepMC::GenEvent deferred;
+  deferred.defer_barcodes();
+  assert( deferred.defers_barcodes() );
+  build( deferred, 100 );
+  assert( deferred.particles_size() == 201 && deferred.vertices_size() == 100 );
+  assert( as_text( deferred ) == as_text( immediate ) );
+  assert( deferred.barcode_to_particle( 10001 ) ==
+          *deferred.barcode_to_vertex( -1 )->particles_in_const_begin() );
+  // particles added after that are deferred again
+  HepMC::GenVertex* v = deferred.barcode_to_vertex( -100 );
+  HepMC::GenParticle* extra = new HepMC::GenParticle( HepMC::FourVector(1,0,0,1), 22, 1 );
+  v->add_particle_out( extra );
+  assert( extra->barcode() == 10202 );
+  assert( deferred.barcode_to_particle( 10202 ) == extra );
+}
+
+void test_barcode_triggers()
+{
+  HepMC::GenEvent evt;
+  evt.defer_barcodes();
+  build( evt, 3 );
+  // asking one particle for its barcode assigns them all
+  HepMC::GenVertex* v = *evt.vertices_begin();
+  assert( v->barcode() == -1 );
+  HepMC::GenParticle* p = *v->particles_in_const_begin();
+  assert( p->barcode() == 10001 );
+  evt.clear();
+  build( evt, 3 );
+  HepMC::GenParticle* last = 0;
+  {
+    HepMC::GenEvent::particle_const_iterator i = evt.particles_begin();
+    for ( ; i != evt.particles_end(); ++i ) last = *i;
+  }
+  assert( last->barcode() == 10007 );
+}
+
+void test_suggested()
+{
+  HepMC::GenEvent evt;
+  evt.defer_barcodes();
+  HepMC::GenVertex* v = new HepMC::GenVertex();
+  v->suggest_barcode( -10 );
+  evt.add_vertex( v );
+  HepMC::GenParticle* a = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 );
+  a->suggest_barcode( 20000 );
+  v->add_particle_out( a );
+  HepMC::GenParticle* b = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 );
+  v->add_particle_out( b );
+  HepMC::GenParticle* c = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 );
+  v->add_particle_out( c );
+  // a waiting particle can still be given a barcode of its own
+  assert( c->suggest_barcode( 5 ) );
+  HepMC::GenVertex* w = new HepMC::GenVertex();
+  evt.add_vertex( w );
+  // the automatic barcodes come after the suggested ones
+  assert( v->barcode() == -10 && a->barcode() == 20000 && c->barcode() == 5 );
+  assert( b->barcode() == 20001 );
+  assert( w->barcode() == -11 );
+  assert( evt.particles_size() == 3 && evt.vertices_size() == 2 );
+}
+
+void test_removed_before_assignment()
+{
+  HepMC::GenEvent evt;
+  evt.defer_barcodes();
+  build( evt, 5 );
+  // remove and delete a waiting vertex and a waiting particle
+  HepMC::GenVertex* v = new HepMC::GenVertex();
+  evt.add_vertex( v );
+  HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 );
+  v->add_particle_out( p );
+  delete v->remove_particle( p );
+  evt.remove_vertex( v );
+  delete v;
+  assert( evt.vertices_size() == 5 && evt.particles_size() == 11 );
+  // a waiting vertex moved to another event
+  HepMC::GenEvent other;
+  other.defer_barcodes();
+  HepMC::GenVertex* moved = new HepMC::GenVertex();
+  evt.add_vertex( moved );
+  other.add_vertex( moved );
+  assert( evt.vertices_size() == 5 );
+  assert( other.vertices_size() == 1 && moved->barcode() == -1 );
+}
+
+void test_pruned()
+{
+  // removing waiting objects anywhere in the lists, the others are
+  // numbered in the order in which they were added
+  HepMC::GenEvent evt;
+  evt.defer_barcodes();
+  HepMC::GenVertex* root = new HepMC::GenVertex();
+  evt.add_vertex( root );
+  std::vector<HepMC::GenVertex*> vertices;
+  std::vector<HepMC::GenParticle*> photons;
+  for ( int k = 0; k < 1000; ++k ) {
+    HepMC::GenVertex* v = new HepMC::GenVertex();
+    evt.add_vertex( v );
+    HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,k,k), 22, 1 );
+    v->add_particle_out( p );
+    vertices.push_back( v );
+    photons.push_back( p );
+  }
+  for ( int k = 0; k < 1000; k += 2 ) {
+    delete vertices[k]->remove_particle( photons[k] );
+    evt.remove_vertex( vertices[k] );
+    delete vertices[k];
+  }
+  assert( evt.vertices_size() == 501 && evt.particles_size() == 500 );
+  assert( root->barcode() == -1 && vertices[1]->barcode() == -2 );
+  assert( vertices[999]->barcode() == -501 );
+  assert( photons[1]->barcode() == 10001 && photons[999]->barcode() == 10500 );
+}
+
+void test_all_removed()
+{
+  // an event whose waiting objects have all been removed is empty
+  HepMC::GenEvent evt;
+  evt.defer_barcodes();
+  HepMC::GenVertex* v = new HepMC::GenVertex();
+  evt.add_vertex( v );
+  v->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 ) );
+  assert( !evt.vertices_empty() && !evt.particles_empty() );
+  evt.remove_vertex( v );
+  delete v;
+  assert( evt.vertices_empty() && evt.particles_empty() );
+  assert( !evt.is_valid() );
+  assert( evt.vertices_size() == 0 && evt.particles_size() == 0 );
+  // and can be filled again
+  v = new HepMC::GenVertex();
+  evt.add_vertex( v );
+  v->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 ) );
+  assert( !evt.vertices_empty() && !evt.particles_empty() );
+  assert( evt.is_valid() );
+  assert( v->barcode() == -1 && evt.barcode_to_particle( 10001 ) );
+}
+
+void test_copy_swap_clear()
+{
+  HepMC::GenEvent reference;
+  build( reference, 10 );
+  std::string text = as_text( reference );
+  HepMC::GenEvent evt;
+  evt.defer_barcodes();
+  build( evt, 10 );
+  HepMC::GenEvent copy( evt );
+  assert( copy.defers_barcodes() );
+  assert( as_text( copy ) == text );
+  HepMC::GenEvent swapped;
+  swapped.swap( copy );
+  assert( as_text( swapped ) == text );
+  assert( copy.particles_empty() );
+  // clearing an event with waiting barcodes deletes everything
+  evt.clear();
+  assert( evt.particles_empty() && evt.vertices_empty() );
+  build( evt, 10 );
+  evt.recycle_objects();
+  evt.clear();
+  build( evt, 10 );
+  assert( as_text( evt ) == text );
+  // switching deferring off assigns the waiting barcodes
+  build( evt, 1 );
+  evt.defer_barcodes( false );
+  assert( !evt.defers_barcodes() );
+  assert( evt.particles_size() == 24 );
+}
+
+int main()
+{
+  test_same_as_immediate();
+  test_barcode_triggers();
+  test_suggested();
+  test_removed_before_assignment();
+  test_pruned();
+  test_all_removed();
+  test_copy_swap_clear();
+  return 0;
+}
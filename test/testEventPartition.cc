@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////////////////
+// testEventPartition.cc
+//
+// EventPartition of an event with many independent collisions, and
+// walks through the parts on several threads
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+#include "HepMC/GenEvent.h"
+#include "HepMC/EventPartition.h"
+
+// collision k: two beams meet at a root vertex, followed by k+1 generations
+// of up to four vertices, neighbours sharing a particle
+HepMC::GenVertex* collide( HepMC::GenEvent& evt, int k )
+{
+  HepMC::GenVertex* root = new HepMC::GenVertex( HepMC::FourVector(0,0,k,0) );
+  root->add_particle_in( new HepMC::GenParticle( HepMC::FourVector(0,0, 100,100), 2212, 4 ) );
+  root->add_particle_in( new HepMC::GenParticle( HepMC::FourVector(0,0,-100,100), 2212, 4 ) );
+  evt.add_vertex( root );
+  std::vector<HepMC::GenVertex*> generation( 1, root );
+  for ( int g = 0; g <= k; ++g ) {
+    std::vector<HepMC::GenVertex*> next;
+    for ( std::size_t i = 0; i < generation.size() && i < 4; ++i ) {
+      HepMC::GenVertex* v = new HepMC::GenVertex( HepMC::FourVector(0,0,k,g+1) );
+      evt.add_vertex( v );
+      HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 211, 2 );
+      generation[i]->add_particle_out( p );
+      v->add_particle_in( p );
+      if ( i > 0 ) {
+        HepMC::GenParticle* q = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 2 );
+        generation[i-1]->add_particle_out( q );
+        v->add_particle_in( q );
+      }
+      next.push_back( v );
+      next.push_back( v );
+    }
+    generation = next;
+  }
+  for ( std::size_t i = 0; i < generation.size(); i += 2 ) {
+    generation[i]->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 111, 1 ) );
+  }
+  return root;
+}
+
+// what the threads find in every part
+struct Walk : public HepMC::EventPartition::Visitor {
+  std::vector<int> descendants;  // of the first vertex of the part
+  std::vector<int> particles;    // of the descendants of the first vertex
+  std::vector<int> depth;        // largest depth in the part
+  std::vector<int> visits;
+  explicit Walk( int n )
+    : descendants( n, 0 ), particles( n, 0 ), depth( n, -1 ), visits( n, 0 ) {}
+  void visit( const HepMC::EventPartition::Part& part ) {
+    const int k = part.index();
+    ++visits[k];
+    HepMC::GenVertex* root = *part.vertices_begin();
+    // the same walk several times, so that the threads overlap
+    for ( int repeat = 0; repeat < 20; ++repeat ) {
+      int n = 0;
+      for ( HepMC::GenVertex::vertex_iterator v = root->vertices_begin( HepMC::descendants );
+            v != root->vertices_end( HepMC::descendants ); ++v ) {
+        // and one inside the other
+        if ( n == 0 ) {
+          int np = 0;
+          for ( HepMC::GenVertex::particle_iterator p = root->particles_begin( HepMC::descendants );
+                p != root->particles_end( HepMC::descendants ); ++p ) ++np;
+          particles[k] = np;
+        }
+        ++n;
+      }
+      descendants[k] = n;
+    }
+    for ( HepMC::EventPartition::Part::vertex_const_iterator v = part.vertices_begin();
+          v != part.vertices_end(); ++v ) {
+      depth[k] = std::max( depth[k], (*v)->depth() );
+    }
+  }
+};
+
+// for_each inside for_each: every inner walk sees every part once
+struct Nested : public HepMC::EventPartition::Visitor {
+  const HepMC::EventPartition& partition;
+  std::vector<int> complete;
+  explicit Nested( const HepMC::EventPartition& p )
+    : partition( p ), complete( p.size(), 0 ) {}
+  void visit( const HepMC::EventPartition::Part& part ) {
+    Walk inner( partition.size() );
+    partition.for_each( inner, 2 );
+    complete[ part.index() ] =
+      std::count( inner.visits.begin(), inner.visits.end(), 1 ) == partition.size();
+  }
+};
+
+int main()
+{
+  const int n = 40;
+  HepMC::GenEvent evt;
+  // barcodes which for_each must give before the threads start
+  evt.defer_barcodes();
+  std::vector<HepMC::GenVertex*> roots;
+  for ( int k = 0; k < n; ++k ) roots.push_back( collide( evt, k % 7 ) );
+  HepMC::EventPartition partition( evt );
+  assert( partition.size() == n );
+  int nv = 0;
+  int np = 0;
+  for ( int k = 0; k < n; ++k ) {
+    HepMC::EventPartition::Part part = partition.part( k );
+    assert( part.index() == k );
+    // the parts come in the order of their first vertex
+    assert( *part.vertices_begin() == roots[k] );
+    for ( HepMC::EventPartition::Part::vertex_const_iterator v = part.vertices_begin();
+          v != part.vertices_end(); ++v ) {
+      assert( partition.part_of( *v ) == k );
+    }
+    for ( HepMC::EventPartition::Part::particle_const_iterator p = part.particles_begin();
+          p != part.particles_end(); ++p ) {
+      const HepMC::GenVertex* v = (*p)->production_vertex() ? (*p)->production_vertex()
+                                                            : (*p)->end_vertex();
+      assert( partition.part_of( v ) == k );
+    }
+    nv += part.vertices_size();
+    np += part.particles_size();
+  }
+  assert( nv == evt.vertices_size() && np == evt.particles_size() );
+  //
+  // the same walks on one thread and on several
+  Walk serial( n );
+  for ( int k = 0; k < n; ++k ) serial.visit( partition.part( k ) );
+  for ( int nthreads = 1; nthreads <= 8; nthreads *= 2 ) {
+    Walk parallel( n );
+    partition.for_each( parallel, nthreads );
+    for ( int k = 0; k < n; ++k ) {
+      assert( parallel.visits[k] == 1 );
+      assert( parallel.descendants[k] == partition.part( k ).vertices_size() );
+      assert( parallel.descendants[k] == serial.descendants[k] );
+      assert( parallel.particles[k] == serial.particles[k] && parallel.particles[k] > 0 );
+      assert( parallel.depth[k] == serial.depth[k] && parallel.depth[k] > 0 );
+    }
+  }
+  //
+  // a visitor may share the event again, and so may the caller
+  Nested nested( partition );
+  partition.for_each( nested, 4 );
+  for ( int k = 0; k < n; ++k ) assert( nested.complete[k] );
+  evt.begin_shared_reading();
+  Walk again( n );
+  partition.for_each( again, 4 );
+  for ( int k = 0; k < n; ++k ) assert( again.visits[k] == 1 );
+  //
+  // joining two collisions joins their parts
+  HepMC::GenVertex* both = new HepMC::GenVertex();
+  evt.add_vertex( both );
+  for ( int k = 3; k <= 5; k += 2 ) {
+    HepMC::GenParticle* link = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 2 );
+    roots[k]->add_particle_out( link );
+    both->add_particle_in( link );
+  }
+  partition.fill( evt );
+  assert( partition.size() == n - 1 );
+  assert( partition.part_of( roots[3] ) == partition.part_of( roots[5] ) );
+  assert( partition.part_of( both ) == 3 );
+  assert( partition.part_of( roots[6] ) == 5 );
+  // vertices of other events
+  HepMC::GenEvent copy( evt );
+  assert( partition.part_of( *copy.vertices_begin() ) == -1 );
+  partition.clear();
+  assert( partition.size() == 0 );
+  partition.for_each( serial, 4 );
+  return 0;
+}
@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////////
+// testFlowIndex.cc
+//
+// FlowIndex against Flow::connected_partners and
+// Flow::dangling_connected_partners in a small colour shower
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+#include "HepMC/GenEvent.h"
+#include "HepMC/FlowIndex.h"
+
+typedef std::vector<HepMC::GenParticle*> FlowVec;
+
+HepMC::GenParticle* parton( HepMC::GenVertex* v, int pdg, int colour, int anticolour )
+{
+  HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), pdg, 2 );
+  if ( colour ) p->set_flow( 1, colour );
+  if ( anticolour ) p->set_flow( 2, anticolour );
+  v->add_particle_out( p );
+  return p;
+}
+
+// a q qbar pair from the vertex, showering into n more partons
+void shower( HepMC::GenEvent& evt, HepMC::GenVertex* hard, int& code, int n )
+{
+  std::vector<HepMC::GenParticle*> open;
+  ++code;
+  open.push_back( parton( hard, 1, code, 0 ) );
+  open.push_back( parton( hard, -1, 0, code ) );
+  unsigned seed = 12345;
+  for ( int k = 0; k < n; ++k ) {
+    seed = seed * 1103515245u + 12345u;
+    const std::size_t i = ( seed >> 8 ) % open.size();
+    HepMC::GenParticle* p = open[i];
+    HepMC::GenVertex* v = new HepMC::GenVertex();
+    evt.add_vertex( v );
+    v->add_particle_in( p );
+    const int c = p->flow( 1 );
+    const int a = p->flow( 2 );
+    ++code;
+    if ( p->pdg_id() == 1 ) {
+      open[i] = parton( v, 1, code, 0 );
+      open.push_back( parton( v, 21, c, code ) );
+    } else if ( p->pdg_id() == -1 ) {
+      open[i] = parton( v, -1, 0, code );
+      open.push_back( parton( v, 21, code, a ) );
+    } else {
+      open[i] = parton( v, 21, c, code );
+      open.push_back( parton( v, 21, code, a ) );
+    }
+  }
+}
+
+FlowVec sorted( FlowVec v )
+{
+  std::sort( v.begin(), v.end() );
+  return v;
+}
+
+int main()
+{
+  HepMC::GenEvent evt;
+  int code = 500;
+  // two showers with the same colour codes, which must not be joined
+  for ( int s = 0; s < 2; ++s ) {
+    HepMC::GenVertex* hard = new HepMC::GenVertex();
+    evt.add_vertex( hard );
+    hard->add_particle_in( new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 11, 3 ) );
+    hard->add_particle_in( new HepMC::GenParticle( HepMC::FourVector(0,0,-1,1), -11, 3 ) );
+    int c = code;
+    shower( evt, hard, c, 60 );
+    if ( s == 1 ) code = c;
+  }
+  HepMC::FlowIndex index( evt );
+  assert( index.size() > 240 );
+  int ncompared = 0;
+  for ( HepMC::GenEvent::particle_const_iterator p = evt.particles_begin();
+        p != evt.particles_end(); ++p ) {
+    for ( int i = 1; i <= 2; ++i ) {
+      const int c = (*p)->flow( i );
+      FlowVec partners = index.connected_partners( *p, c );
+      FlowVec dangling = index.dangling_connected_partners( *p, c );
+      if ( !c ) {
+        assert( partners.empty() && dangling.empty() );
+        continue;
+      }
+      assert( sorted( partners ) == sorted( (*p)->flow().connected_partners( c ) ) );
+      assert( sorted( dangling ) == sorted( (*p)->flow().dangling_connected_partners( c ) ) );
+      // a colour line has two ends
+      assert( partners.size() >= 2 && dangling.size() == 2 );
+      for ( std::size_t k = 1; k < partners.size(); ++k ) {
+        assert( partners[k-1]->barcode() < partners[k]->barcode() );
+      }
+      // one code index only
+      assert( sorted( index.connected_partners( *p, c, i, 1 ) )
+              == sorted( (*p)->flow().connected_partners( c, i, 1 ) ) );
+      assert( sorted( index.dangling_connected_partners( *p, c, i, 1 ) )
+              == sorted( (*p)->flow().dangling_connected_partners( c, i, 1 ) ) );
+      ++ncompared;
+    }
+  }
+  assert( ncompared > 240 );
+  // a particle of another event
+  HepMC::GenEvent copy( evt );
+  HepMC::GenParticle* coloured = 0;
+  for ( HepMC::GenEvent::particle_const_iterator p = copy.particles_begin();
+        p != copy.particles_end() && !coloured; ++p ) {
+    if ( (*p)->flow( 1 ) ) coloured = *p;
+  }
+  assert( coloured );
+  assert( index.connected_partners( coloured, coloured->flow( 1 ) ).empty() );
+  index.fill( copy );
+  assert( !index.connected_partners( coloured, coloured->flow( 1 ) ).empty() );
+  index.clear();
+  assert( index.size() == 0 );
+  return 0;
+}
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////
+// testFlowStorage.cc
+//
+// flow codes stored inline and out of line, polarization only when set
+// run with valgrind or some other leak checker
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+
+#include "HepMC/GenParticle.h"
+
+void test_flow()
+{
+  HepMC::Flow f;
+  assert( f.empty() && f.begin() == f.end() );
+  // codes are kept in the order of their code index
+  f.set_icode( 2, 502 );
+  f.set_icode( 1, 501 );
+  assert( f.size() == 2 );
+  assert( f.begin()->first == 1 && f.begin()->second == 501 );
+  assert( f.icode( 2 ) == 502 && f.icode( 3 ) == 0 );
+  f.set_icode( 2, 602 );
+  assert( f.size() == 2 && f.icode( 2 ) == 602 );
+  // more than two codes
+  f.set_icode( 4, 504 );
+  f.set_icode( 3, 503 );
+  f.set_icode( 0, 500 );
+  assert( f.size() == 5 );
+  int index = 0;
+  for ( HepMC::Flow::const_iterator i = f.begin(); i != f.end(); ++i, ++index ) {
+    assert( i->first == index );
+  }
+  assert( f.icode( 4 ) == 504 );
+  // copies and equality
+  HepMC::Flow g( f );
+  assert( g == f );
+  g.set_icode( 3, 0 );
+  assert( g != f );
+  HepMC::Flow h;
+  h.set_icode( 7, 1 );
+  h = f;
+  assert( h == f );
+  // erasing codes brings them back inline
+  assert( !f.erase( 9 ) );
+  assert( f.erase( 0 ) && f.erase( 3 ) && f.erase( 2 ) );
+  assert( f.size() == 2 && f.icode( 1 ) == 501 && f.icode( 4 ) == 504 );
+  assert( f.erase( 1 ) );
+  assert( f.size() == 1 && f.icode( 4 ) == 504 );
+  f.swap( g );
+  assert( f.size() == 5 && g.size() == 1 && g.icode( 4 ) == 504 );
+  f.clear();
+  assert( f.empty() && f.icode( 1 ) == 0 );
+}
+
+void test_particle()
+{
+  HepMC::GenParticle p( HepMC::FourVector(0,0,1,1), 21, 2 );
+  assert( p.polarization() == HepMC::Polarization( 0, 0 ) );
+  p.set_flow( 1, 501 );
+  p.set_flow( 2, 502 );
+  p.set_flow( 3, 503 );
+  p.set_polarization( HepMC::Polarization( 0.5, 1.5 ) );
+  HepMC::GenParticle q( p );
+  assert( q == p );
+  assert( q.flow( 3 ) == 503 );
+  assert( q.polarization().theta() == 0.5 );
+  p.set_polarization();
+  assert( p.polarization() == HepMC::Polarization( 0, 0 ) );
+  assert( q.polarization().phi() == 1.5 );
+  HepMC::GenParticle r;
+  r = q;
+  assert( r.polarization() == q.polarization() && r.flow() == q.flow() );
+  p.swap( r );
+  assert( p.polarization().theta() == 0.5 );
+  assert( r.polarization() == HepMC::Polarization( 0, 0 ) );
+}
+
+int main()
+{
+  test_flow();
+  test_particle();
+  return 0;
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////
+// testLineReader.cc
+//
+// detail::LineReader must read the same values as a std::istringstream,
+// and fail in the same places
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "HepMC/StreamHelpers.h"
+
+// the same bits, so that -0 and 0 are different
+bool same( double a, double b ) { return std::memcmp( &a, &b, sizeof(double) ) == 0; }
+bool same( float a, float b ) { return std::memcmp( &a, &b, sizeof(float) ) == 0; }
+
+// read line as a sequence of T with both, and compare
+template <class T>
+void compare( const std::string& line )
+{
+  std::istringstream stream( line );
+  HepMC::detail::LineReader reader( line );
+  for ( int i = 0; i < 8; ++i ) {
+    T a = 0, b = 0;
+    stream >> a;
+    reader >> b;
+    assert( !stream == !reader );
+    if ( !stream ) return;
+    assert( same( (double)a, (double)b ) );
+    assert( stream.eof() == reader.eof() );
+  }
+}
+
+int main()
+{
+  const char* lines[] = {
+    "", "  ", "0", "-0", "+7 -12 007", "12 x", "2147483647 2147483648", "-2147483648 -2147483649",
+    "1.5", "3.25e2 -1.0e-3", "1e", "1e+", "-", "+.5e-3", "5.", ".", "1.5.5", "1e5e5",
+    "\t12\t-3 ", "4.5035996273704965e15 9007199254740993 9007199254740995",
+    "1.7976931348623157e308 1.8e308 -1.8e308", "2.2250738585072014e-308 4.9e-324 1e-400",
+    "0.000000000000000000000000000001 123456789012345678901234567",
+    "7.2521029125687850e-02 4.0916270130125820e-01 2.3327360517627892e+02" };
+  const int nlines = sizeof(lines) / sizeof(lines[0]);
+  for ( int k = 0; k < nlines; ++k ) {
+    compare<int>( lines[k] );
+    compare<long>( lines[k] );
+    compare<unsigned int>( lines[k] );
+    compare<unsigned long>( lines[k] );
+    compare<double>( lines[k] );
+    compare<float>( lines[k] );
+  }
+  //
+  // numbers as IO_GenEvent writes them, over the whole range
+  unsigned long seed = 12345;
+  for ( int k = 0; k < 20000; ++k ) {
+    seed = ( seed * 1103515245UL + 12345UL ) & 0x7fffffffUL;
+    const double mantissa = (double)seed / 0x7fffffffUL - 0.5;
+    std::ostringstream out;
+    out.precision( 16 );
+    out.setf( std::ios::scientific, std::ios::floatfield );
+    double x = mantissa;
+    for ( int e = (int)( seed % 80 ) - 40; e > 0; --e ) x *= 10;
+    for ( int e = (int)( seed % 80 ) - 40; e < 0; ++e ) x /= 10;
+    out << x << ' ' << (float)x << ' ' << (long)( mantissa * 2.e9 );
+    compare<double>( out.str() );
+    compare<float>( out.str() );
+    compare<long>( out.str() );
+  }
+  //
+  // words, and reads after a failure
+  std::string line( "P 12 abc 3" );
+  HepMC::detail::LineReader reader( line );
+  std::string word;
+  int i = 0;
+  reader >> word >> i;
+  assert( word == "P" && i == 12 && !!reader );
+  reader >> i;
+  assert( !reader && !reader.eof() );
+  reader >> word;
+  assert( !reader && word == "P" );
+  //
+  // characters of numbers only, after the line type
+  assert( HepMC::detail::numbers_only( "V -1 0 1.5e+00\t-3", 1 ) );
+  assert( !HepMC::detail::numbers_only( "V -1 0 nan", 1 ) );
+  assert( !HepMC::detail::numbers_only( "V -1 0 1,5", 1 ) );
+  return 0;
+}
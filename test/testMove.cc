@@ -0,0 +1,164 @@
+//////////////////////////////////////////////////////////////////////////
+// testMove.cc
+//
+// move constructors and move assignment of the event record classes
+// (only available when compiling with C++11 or later)
+// run with valgrind or some other leak checker
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HepMC/GenEvent.h"
+
+#ifdef HEPMC_HAS_MOVE_SEMANTICS
+
+std::string as_text( HepMC::GenEvent& evt )
+{
+  std::ostringstream os;
+  evt.write( os );
+  return os.str();
+}
+
+// a small event with beam particles, a signal vertex and colour flow
+HepMC::GenEvent make_event( int number )
+{
+  HepMC::GenEvent evt( 20, number );
+  HepMC::GenVertex* v1 = new HepMC::GenVertex( HepMC::FourVector(0,0,0,0) );
+  evt.add_vertex( v1 );
+  HepMC::GenParticle* b1 = new HepMC::GenParticle( HepMC::FourVector(0,0,7000,7000), 2212, 4 );
+  HepMC::GenParticle* b2 = new HepMC::GenParticle( HepMC::FourVector(0,0,-7000,7000), 2212, 4 );
+  v1->add_particle_in( b1 );
+  v1->add_particle_in( b2 );
+  HepMC::GenParticle* q = new HepMC::GenParticle( HepMC::FourVector(0,1,2,3), 1, 2 );
+  q->set_flow( 1, 501 );
+  v1->add_particle_out( q );
+  HepMC::GenVertex* v2 = new HepMC::GenVertex( HepMC::FourVector(1,2,3,4) );
+  evt.add_vertex( v2 );
+  v2->add_particle_in( q );
+  v2->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,1,1,2), 211, 1 ) );
+  evt.set_beam_particles( b1, b2 );
+  evt.set_signal_process_vertex( v2 );
+  evt.weights().push_back( 1.5 );
+  return evt;
+}
+
+void test_event()
+{
+  HepMC::GenEvent ref = make_event( 7 );
+  std::string text = as_text( ref );
+  // move construction takes over the whole graph
+  HepMC::GenEvent moved( std::move( ref ) );
+  assert( as_text( moved ) == text );
+  assert( ref.particles_size() == 0 && ref.vertices_size() == 0 );
+  assert( moved.signal_process_vertex()->parent_event() == &moved );
+  for ( HepMC::GenEvent::vertex_const_iterator v = moved.vertices_begin();
+        v != moved.vertices_end(); ++v ) {
+    assert( (*v)->parent_event() == &moved );
+  }
+  // move assignment discards the old content
+  HepMC::GenEvent target = make_event( 8 );
+  target = std::move( moved );
+  assert( as_text( target ) == text );
+  assert( moved.particles_size() == 0 );
+  // events can be kept by value in containers
+  std::vector<HepMC::GenEvent> events;
+  for ( int i = 0; i < 10; ++i ) events.push_back( make_event( i ) );
+  for ( int i = 0; i < 10; ++i ) {
+    assert( events[i].event_number() == i );
+    assert( events[i].valid_beam_particles() );
+    assert( events[i].particles_begin() != events[i].particles_end() );
+    assert( (*events[i].vertices_begin())->parent_event() == &events[i] );
+  }
+}
+
+void test_vertex_and_particle()
+{
+  HepMC::GenEvent evt = make_event( 1 );
+  HepMC::GenVertex* v2 = evt.signal_process_vertex();
+  int vbarcode = v2->barcode();
+  HepMC::GenParticle* q = *v2->particles_in_const_begin();
+  int qbarcode = q->barcode();
+  std::string text = as_text( evt );
+
+  // a moved particle takes the place of the original in the event
+  HepMC::GenParticle* q2 = new HepMC::GenParticle( std::move( *q ) );
+  assert( q->production_vertex() == 0 && q->end_vertex() == 0 );
+  assert( q->flow().empty() );
+  delete q;
+  assert( q2->barcode() == qbarcode );
+  assert( q2->flow( 1 ) == 501 );
+  assert( q2->flow().particle_owner() == q2 );
+  assert( evt.barcode_to_particle( qbarcode ) == q2 );
+  assert( q2->end_vertex() == v2 );
+  assert( *v2->particles_in_const_begin() == q2 );
+  // the beam particles are followed as well
+  HepMC::GenParticle* b1 = evt.beam_particles().first;
+  HepMC::GenParticle* b1moved = new HepMC::GenParticle( std::move( *b1 ) );
+  delete b1;
+  assert( evt.beam_particles().first == b1moved );
+  assert( as_text( evt ) == text );
+
+  // a moved vertex takes over the particles and the place of the original
+  HepMC::GenVertex* v3 = new HepMC::GenVertex( std::move( *v2 ) );
+  assert( v2->particles_in_size() == 0 && v2->particles_out_size() == 0 );
+  assert( v2->parent_event() == 0 && v2->barcode() == 0 );
+  delete v2;
+  assert( v3->barcode() == vbarcode );
+  assert( v3->parent_event() == &evt );
+  assert( evt.barcode_to_vertex( vbarcode ) == v3 );
+  assert( evt.signal_process_vertex() == v3 );
+  assert( q2->end_vertex() == v3 );
+  assert( as_text( evt ) == text );
+
+  // move assignment transfers the properties only
+  HepMC::GenParticle p( HepMC::FourVector(0,0,1,1), 22, 1 );
+  p = std::move( *q2 );
+  assert( p.pdg_id() == 1 && p.flow( 1 ) == 501 );
+  assert( p.end_vertex() == 0 && p.barcode() == 0 );
+  assert( q2->end_vertex() == v3 );
+}
+
+void test_containers()
+{
+  HepMC::WeightContainer w;
+  w["first"] = 1.;
+  w["second"] = 2.;
+  HepMC::WeightContainer w2( std::move( w ) );
+  assert( w.empty() );
+  assert( w2.size() == 2 && w2["second"] == 2. );
+  w = std::move( w2 );
+  assert( w2.empty() );
+  assert( w.size() == 2 && w["first"] == 1. );
+
+  HepMC::Flow f;
+  f.set_icode( 1, 501 );
+  HepMC::Flow f2( std::move( f ) );
+  assert( f.empty() );
+  assert( f2.icode( 1 ) == 501 );
+  f = std::move( f2 );
+  assert( f2.empty() );
+  assert( f.icode( 1 ) == 501 );
+}
+
+int main()
+{
+  test_event();
+  test_vertex_and_particle();
+  test_containers();
+  return 0;
+}
+
+#else
+
+int main()
+{
+  // nothing to test without C++11
+  return 0;
+}
+
+#endif // HEPMC_HAS_MOVE_SEMANTICS
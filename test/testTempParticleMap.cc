@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////
+// testTempParticleMap.cc
+//
+// TempParticleMap gives the particles in the order of their barcodes,
+// whatever the order in which they were added
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <vector>
+
+#include "HepMC/GenParticle.h"
+#include "HepMC/TempParticleMap.h"
+
+int main()
+{
+  const int barcodes[] = { 10003, 10001, 10007, 10001, 10002 };
+  const int n = sizeof(barcodes) / sizeof(barcodes[0]);
+  std::vector<HepMC::GenParticle*> particles;
+  HepMC::TempParticleMap map;
+  map.reserve( n );
+  for ( int k = 0; k < n; ++k ) {
+    HepMC::GenParticle* p = new HepMC::GenParticle();
+    p->suggest_barcode( barcodes[k] );
+    int end_vertex = -1 - k;
+    map.addEndParticle( p, end_vertex );
+    particles.push_back( p );
+  }
+  assert( map.size() == (std::size_t)n );
+  const int order[] = { 1, 3, 4, 0, 2 };
+  int k = 0;
+  for ( HepMC::TempParticleMap::orderIterator it = map.order_begin();
+        it != map.order_end(); ++it, ++k ) {
+    // equal barcodes stay in the order in which they were added
+    assert( it->second == particles[ order[k] ] );
+    assert( it->first == barcodes[ order[k] ] );
+    assert( it->end_vertex == -1 - order[k] );
+  }
+  assert( k == n );
+  // the end vertices looked up by particle, as before
+  for ( int j = 0; j < n; ++j ) assert( map.end_vertex( particles[j] ) == -1 - j );
+  assert( map.end_vertex( 0 ) == 0 );
+  int nmapped = 0;
+  for ( HepMC::TempParticleMap::TempMapIterator it = map.begin(); it != map.end(); ++it ) {
+    assert( it->second == map.end_vertex( it->first ) );
+    ++nmapped;
+  }
+  assert( nmapped == n );
+  for ( std::size_t j = 0; j < particles.size(); ++j ) delete particles[j];
+  return 0;
+}
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////
+// testVertexTraversal.cc
+//
+// GenVertex::vertex_iterator in nested and interleaved loops, copied
+// halfway and outside an event
+//////////////////////////////////////////////////////////////////////////
+
+// the checks must also be made in optimised builds
+#undef NDEBUG
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+#include "HepMC/GenEvent.h"
+
+typedef std::vector<HepMC::GenVertex*> Vertices;
+
+// a ladder of n rungs: every vertex decays into the next two, which
+// also share a particle, so that most vertices are reached twice
+Vertices build( int n )
+{
+  Vertices v;
+  for ( int k = 0; k < 2*n; ++k ) {
+    v.push_back( new HepMC::GenVertex( HepMC::FourVector(0,0,0,k) ) );
+  }
+  v[0]->add_particle_in( new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 2212, 4 ) );
+  for ( int k = 0; k + 2 < 2*n; ++k ) {
+    HepMC::GenParticle* p = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 1, 2 );
+    v[k]->add_particle_out( p );
+    v[k+2]->add_particle_in( p );
+    if ( k % 2 == 0 ) {
+      HepMC::GenParticle* q = new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 21, 2 );
+      v[k]->add_particle_out( q );
+      v[k+1]->add_particle_in( q );
+    }
+  }
+  v[2*n-1]->add_particle_out( new HepMC::GenParticle( HepMC::FourVector(0,0,1,1), 22, 1 ) );
+  return v;
+}
+
+Vertices walk( HepMC::GenVertex* root, HepMC::IteratorRange range )
+{
+  Vertices out;
+  for ( HepMC::GenVertex::vertex_iterator v = root->vertices_begin( range );
+        v != root->vertices_end( range ); ++v ) {
+    out.push_back( *v );
+  }
+  return out;
+}
+
+void check( const Vertices& v )
+{
+  const Vertices all = walk( v[0], HepMC::descendants );
+  assert( all.size() == v.size() );
+  // post order: the root comes last
+  assert( all.back() == v[0] );
+  // a traversal inside a traversal of the same vertices
+  Vertices outer;
+  for ( HepMC::GenVertex::vertex_iterator i = v[0]->vertices_begin( HepMC::descendants );
+        i != v[0]->vertices_end( HepMC::descendants ); ++i ) {
+    outer.push_back( *i );
+    Vertices inner = walk( *i, HepMC::ancestors );
+    assert( inner.back() == *i );
+    assert( std::find( inner.begin(), inner.end(), v[0] ) != inner.end() );
+  }
+  assert( outer == all );
+  // two traversals of the same vertices advanced in turn
+  Vertices first, second;
+  HepMC::GenVertex::vertex_iterator a = v[0]->vertices_begin( HepMC::descendants );
+  HepMC::GenVertex::vertex_iterator b = v[0]->vertices_begin( HepMC::descendants );
+  for ( ; a != v[0]->vertices_end( HepMC::descendants ); ++a, ++b ) {
+    first.push_back( *a );
+    second.push_back( *b );
+  }
+  assert( first == all && second == all );
+  // a copy made halfway goes on independently of the original
+  HepMC::GenVertex::vertex_iterator i = v[0]->vertices_begin( HepMC::descendants );
+  for ( std::size_t k = 0; k < all.size() / 2; ++k ) ++i;
+  HepMC::GenVertex::vertex_iterator copy = i;
+  Vertices rest_of_copy;
+  for ( ; copy != v[0]->vertices_end( HepMC::descendants ); ++copy ) {
+    rest_of_copy.push_back( *copy );
+  }
+  Vertices rest;
+  for ( ; i != v[0]->vertices_end( HepMC::descendants ); ++i ) rest.push_back( *i );
+  assert( rest == rest_of_copy );
+  assert( rest.size() == all.size() - all.size() / 2 );
+  // particles of the whole graph, each once
+  int nparticles = 0;
+  for ( HepMC::GenVertex::particle_iterator p = v[5]->particles_begin( HepMC::relatives );
+        p != v[5]->particles_end( HepMC::relatives ); ++p ) {
+    ++nparticles;
+  }
+  assert( nparticles == (int)( v.size() + v.size() / 2 - 1 ) );
+}
+
+int main()
+{
+  // vertices which do not belong to an event
+  Vertices v = build( 50 );
+  check( v );
+  // the same vertices in an event
+  HepMC::GenEvent evt;
+  for ( std::size_t k = 0; k < v.size(); ++k ) evt.add_vertex( v[k] );
+  check( v );
+  // the order does not depend on where the vertices are kept
+  HepMC::GenEvent copy( evt );
+  Vertices w;
+  for ( std::size_t k = 0; k < v.size(); ++k ) {
+    w.push_back( copy.barcode_to_vertex( v[k]->barcode() ) );
+  }
+  Vertices a = walk( v[0], HepMC::relatives );
+  Vertices b = walk( w[0], HepMC::relatives );
+  assert( a.size() == b.size() );
+  for ( std::size_t k = 0; k < a.size(); ++k ) assert( a[k]->barcode() == b[k]->barcode() );
+  return 0;
+}